@@ -0,0 +1,109 @@
+import { describe, it, expect, beforeEach, vi } from "vitest";
+import { waitForChange, fingerprint, clear } from "../index.js";
+import type { WatchSource } from "../index.js";
+import type { EntityState } from "../../integrations/homeassistant/index.js";
+
+function entity(state: string, attributes: Record<string, unknown> = {}): EntityState {
+  return {
+    entity_id: "sensor.test",
+    state,
+    attributes,
+    last_changed: new Date().toISOString(),
+    last_updated: new Date().toISOString(),
+  };
+}
+
+// Source whose single entity state can be changed while a wait is running
+function makeSource(initial: string) {
+  let current = initial;
+  const source: WatchSource = {
+    entityIds: vi.fn(async () => ["sensor.test"]),
+    states: vi.fn(async () => ({ sensor_test: entity(current) })),
+    pollIntervalMs: 10,
+  };
+  return {
+    source,
+    setState(state: string) {
+      current = state;
+    },
+  };
+}
+
+describe("change watcher", () => {
+  beforeEach(() => {
+    clear();
+  });
+
+  describe("fingerprint", () => {
+    it("should ignore timestamps but not state or attributes", () => {
+      const a = { sensor_test: entity("21.5", { unit: "°C" }) };
+      const b = { sensor_test: { ...entity("21.5", { unit: "°C" }), last_updated: "2000-01-01T00:00:00Z" } };
+
+      expect(fingerprint(a)).toBe(fingerprint(b));
+      expect(fingerprint({ sensor_test: entity("22.0", { unit: "°C" }) })).not.toBe(fingerprint(a));
+      expect(fingerprint({ sensor_test: entity("21.5", { unit: "K" }) })).not.toBe(fingerprint(a));
+      expect(fingerprint({ sensor_test: null })).not.toBe(fingerprint(a));
+    });
+  });
+
+  describe("waitForChange", () => {
+    it("should answer at once without a previous token", async () => {
+      const { source } = makeSource("on");
+
+      const result = await waitForChange("test.html", undefined, 10000, undefined, source);
+
+      expect(result.changed).toBe(true);
+      expect(result.token).toMatch(/^"[0-9a-f]{16}"$/);
+      expect(result.entities).toBe(1);
+    });
+
+    it("should time out when nothing changes", async () => {
+      const { source } = makeSource("on");
+      const first = await waitForChange("test.html", undefined, 0, undefined, source);
+
+      const result = await waitForChange("test.html", first.token, 50, undefined, source);
+
+      expect(result.changed).toBe(false);
+      expect(result.token).toBe(first.token);
+    });
+
+    it("should return as soon as a state changes", async () => {
+      const { source, setState } = makeSource("off");
+      const first = await waitForChange("test.html", undefined, 0, undefined, source);
+
+      const waiting = waitForChange("test.html", first.token, 5000, undefined, source);
+      setTimeout(() => setState("on"), 30);
+      const result = await waiting;
+
+      expect(result.changed).toBe(true);
+      expect(result.token).not.toBe(first.token);
+    });
+
+    it("should share polls between waiting devices", async () => {
+      const { source } = makeSource("on");
+      const first = await waitForChange("test.html", undefined, 0, undefined, source);
+      vi.mocked(source.states).mockClear();
+
+      await Promise.all([
+        waitForChange("test.html", first.token, 35, undefined, source),
+        waitForChange("test.html", first.token, 35, undefined, source),
+        waitForChange("test.html", first.token, 35, undefined, source),
+      ]);
+
+      // One fetch per poll interval, not one per device
+      expect(vi.mocked(source.states).mock.calls.length).toBeLessThanOrEqual(6);
+    });
+
+    it("should stop waiting when aborted", async () => {
+      const { source } = makeSource("on");
+      const first = await waitForChange("test.html", undefined, 0, undefined, source);
+      const abort = new AbortController();
+
+      const waiting = waitForChange("test.html", first.token, 10000, abort.signal, source);
+      setTimeout(() => abort.abort(), 20);
+      const result = await waiting;
+
+      expect(result.changed).toBe(false);
+    });
+  });
+});
@@ -0,0 +1,76 @@
+import { IncomingMessage, ServerResponse } from "node:http";
+import { ACTIVE_TEMPLATE_ID } from "../core/constants.js";
+import { templateExists } from "../templates/index.js";
+import { waitForChange } from "./watcher.js";
+
+/** Longest a device may hold a request open */
+export const MAX_TIMEOUT_SEC = 300;
+const DEFAULT_TIMEOUT_SEC = 60;
+
+function sendJson(res: ServerResponse, statusCode: number, body: unknown): void {
+  res.writeHead(statusCode, { "Content-Type": "application/json" });
+  res.end(JSON.stringify(body));
+}
+
+/**
+ * Handle GET /changes: long-poll until an entity used by the template changes
+ *
+ * The device sends its last token as If-None-Match. The response is 200 with a
+ * new ETag as soon as the states differ, or 304 after ?timeout= seconds
+ * without a change. Without If-None-Match it answers at once with the current token.
+ */
+export async function handleChanges(
+  req: IncomingMessage,
+  res: ServerResponse,
+  params: Record<string, string>
+): Promise<void> {
+  const templateName = params.template || ACTIVE_TEMPLATE_ID;
+  const timeoutSec = params.timeout ? parseInt(params.timeout, 10) : DEFAULT_TIMEOUT_SEC;
+
+  if (isNaN(timeoutSec) || timeoutSec < 0 || timeoutSec > MAX_TIMEOUT_SEC) {
+    sendJson(res, 400, {
+      error: "Invalid timeout parameter",
+      message: `Timeout must be between 0 and ${MAX_TIMEOUT_SEC} seconds`,
+    });
+    return;
+  }
+
+  if (!templateExists(templateName)) {
+    sendJson(res, 404, { error: "Template not found", message: `Template '${templateName}' not found` });
+    return;
+  }
+
+  // Stop polling for a device that has gone away
+  const abort = new AbortController();
+  res.on("close", () => abort.abort());
+
+  try {
+    const since = req.headers["if-none-match"];
+    const result = await waitForChange(templateName, since, timeoutSec * 1000, abort.signal);
+
+    if (res.destroyed) {
+      return;
+    }
+
+    if (!result.changed) {
+      res.writeHead(304, { ETag: result.token });
+      res.end();
+      return;
+    }
+
+    const body = JSON.stringify({ template: templateName, token: result.token, entities: result.entities });
+    res.writeHead(200, {
+      "Content-Type": "application/json",
+      "Content-Length": Buffer.byteLength(body),
+      ETag: result.token,
+    });
+    res.end(body);
+  } catch (error) {
+    if (!res.destroyed) {
+      sendJson(res, 503, {
+        error: "State unavailable",
+        message: error instanceof Error ? error.message : String(error),
+      });
+    }
+  }
+}
@@ -0,0 +1,7 @@
+/**
+ * Change notification module barrel export
+ */
+
+export { waitForChange, fingerprint, clear } from "./watcher.js";
+export type { WatchSource, WaitResult } from "./watcher.js";
+export { handleChanges, MAX_TIMEOUT_SEC } from "./handler.js";
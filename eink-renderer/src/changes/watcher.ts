@@ -0,0 +1,143 @@
+/**
+ * Entity change detection for long-polling devices
+ *
+ * A template's state token is the ETag of the Home Assistant states it
+ * references. Waiting devices share one poll per template and interval.
+ * A new token drops the template's cached HTML and images, so the /image
+ * request a woken device sends next renders the new states.
+ */
+
+import * as renderedCache from "../core/cache/index.js";
+import { imageCache } from "../core/cache/index.js";
+import { computeEtag, etagMatches } from "../core/etag.js";
+import { loadTemplate, extractEntityIds } from "../templates/index.js";
+import { getMultipleStates } from "../integrations/homeassistant/index.js";
+import type { EntityState } from "../integrations/homeassistant/index.js";
+
+/** How the watcher reaches templates and Home Assistant (replaced in tests) */
+export interface WatchSource {
+  entityIds(templateName: string): Promise<string[]>;
+  states(entityIds: string[]): Promise<Record<string, EntityState | null>>;
+  /** Minimum time between Home Assistant polls for one template */
+  pollIntervalMs: number;
+}
+
+export interface WaitResult {
+  changed: boolean;
+  token: string;
+  entities: number;
+}
+
+interface Snapshot {
+  token: string;
+  entities: number;
+  fetchedAt: number;
+}
+
+const defaultSource: WatchSource = {
+  entityIds: async (templateName) => extractEntityIds(await loadTemplate(templateName)),
+  states: getMultipleStates,
+  pollIntervalMs: 5000,
+};
+
+const snapshots = new Map<string, Snapshot>();
+const pending = new Map<string, Promise<Snapshot>>();
+
+/**
+ * Token for a set of entity states; timestamps are left out so only
+ * state or attribute changes produce a new token
+ */
+export function fingerprint(states: Record<string, EntityState | null>): string {
+  const parts = Object.keys(states)
+    .sort()
+    .map((key) => {
+      const entity = states[key];
+      return [key, entity ? entity.state : null, entity ? entity.attributes : null];
+    });
+  return computeEtag(JSON.stringify(parts));
+}
+
+/**
+ * Current snapshot of a template, fetched at most once per poll interval
+ */
+function currentSnapshot(templateName: string, source: WatchSource): Promise<Snapshot> {
+  const snapshot = snapshots.get(templateName);
+  if (snapshot && Date.now() - snapshot.fetchedAt < source.pollIntervalMs) {
+    return Promise.resolve(snapshot);
+  }
+
+  const inFlight = pending.get(templateName);
+  if (inFlight) {
+    return inFlight;
+  }
+
+  const promise = (async () => {
+    // Reloaded on every poll so template edits are picked up
+    const entityIds = await source.entityIds(templateName);
+    const states = await source.states(entityIds);
+    const fresh = { token: fingerprint(states), entities: entityIds.length, fetchedAt: Date.now() };
+    const previous = snapshots.get(templateName);
+    if (previous && previous.token !== fresh.token) {
+      renderedCache.remove(`ha:${templateName}`);
+      imageCache.invalidate(`template:${templateName}`);
+    }
+    snapshots.set(templateName, fresh);
+    return fresh;
+  })().finally(() => {
+    pending.delete(templateName);
+  });
+
+  pending.set(templateName, promise);
+  return promise;
+}
+
+function sleep(ms: number, signal?: AbortSignal): Promise<void> {
+  return new Promise((resolve) => {
+    const timer = setTimeout(done, ms);
+    function done() {
+      clearTimeout(timer);
+      signal?.removeEventListener("abort", done);
+      resolve();
+    }
+    signal?.addEventListener("abort", done);
+  });
+}
+
+/**
+ * Wait until the state token of a template differs from since
+ * Returns at once when since is empty or already stale, otherwise after
+ * the first change or when timeoutMs has passed (changed: false)
+ * @param since Token from the previous result (If-None-Match format)
+ * @param signal Aborts the wait, e.g. when the device disconnects
+ */
+export async function waitForChange(
+  templateName: string,
+  since: string | undefined,
+  timeoutMs: number,
+  signal?: AbortSignal,
+  source: WatchSource = defaultSource
+): Promise<WaitResult> {
+  const deadline = Date.now() + timeoutMs;
+
+  for (;;) {
+    const snapshot = await currentSnapshot(templateName, source);
+    if (!etagMatches(since, snapshot.token)) {
+      return { changed: true, token: snapshot.token, entities: snapshot.entities };
+    }
+
+    const remaining = deadline - Date.now();
+    if (remaining <= 0 || signal?.aborted) {
+      return { changed: false, token: snapshot.token, entities: snapshot.entities };
+    }
+
+    await sleep(Math.min(source.pollIntervalMs, remaining), signal);
+  }
+}
+
+/**
+ * Forget all snapshots (useful for testing)
+ */
+export function clear(): void {
+  snapshots.clear();
+  pending.clear();
+}
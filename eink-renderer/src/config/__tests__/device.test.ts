@@ -0,0 +1,80 @@
+import { describe, it, expect } from "vitest";
+import { parseCapabilities, choosePolicy, DEFAULT_POLICY } from "../index.js";
+
+const query = {
+  panel: "GxEPD2_583_T8",
+  width: "648",
+  height: "480",
+  heap: "182000",
+  psram: "0",
+  formats: "epd1,rle,bmp",
+  partial: "1",
+  sleep: "0",
+  fw: "1.1.0",
+};
+
+describe("device policy", () => {
+  describe("parseCapabilities", () => {
+    it("should read the capabilities from the query", () => {
+      expect(parseCapabilities(query)).toEqual({
+        panel: "GxEPD2_583_T8",
+        width: 648,
+        height: 480,
+        freeHeap: 182000,
+        psram: 0,
+        formats: ["epd1", "rle", "bmp"],
+        partialRefresh: true,
+        deepSleep: false,
+        firmware: "1.1.0",
+      });
+    });
+
+    it("should return null for a device that sends none", () => {
+      expect(parseCapabilities({ verbose: "true" })).toBeNull();
+    });
+
+    it("should drop formats the renderer cannot serve to a device", () => {
+      expect(parseCapabilities({ formats: "png,EPD1, bmp" })?.formats).toEqual(["epd1", "bmp"]);
+    });
+  });
+
+  describe("choosePolicy", () => {
+    it("should keep the fleet defaults without capabilities", () => {
+      expect(choosePolicy(null)).toEqual(DEFAULT_POLICY);
+    });
+
+    it("should pick the smallest format and the panel's own size", () => {
+      const policy = choosePolicy(parseCapabilities(query));
+
+      expect(policy.format).toBe("rle");
+      expect(policy.stream).toBe(true);
+      expect(policy.width).toBe(648);
+      expect(policy.height).toBe(480);
+      expect(policy.partialRefreshCycles).toBe(10);
+      expect(policy.stayAwakeFeatures).toBe(true);
+    });
+
+    it("should fall back to formats the device lists", () => {
+      expect(choosePolicy(parseCapabilities({ ...query, formats: "bmp" })).format).toBe("bmp");
+      expect(choosePolicy(parseCapabilities({ ...query, formats: "" })).format).toBe("bmp");
+    });
+
+    it("should use full refreshes only on panels without a partial waveform", () => {
+      const policy = choosePolicy(parseCapabilities({ ...query, partial: "0" }));
+
+      expect(policy.partialRefreshCycles).toBe(0);
+      expect(policy.fullRefreshMinutes).toBe(0);
+    });
+
+    it("should ignore a size the firmware cannot address", () => {
+      const policy = choosePolicy(parseCapabilities({ ...query, width: "645" }));
+
+      expect(policy.width).toBe(DEFAULT_POLICY.width);
+      expect(policy.height).toBe(DEFAULT_POLICY.height);
+    });
+
+    it("should leave stay-awake features out for deep sleeping devices", () => {
+      expect(choosePolicy(parseCapabilities({ ...query, sleep: "1" })).stayAwakeFeatures).toBe(false);
+    });
+  });
+});
@@ -0,0 +1,101 @@
+import { describe, it, expect, beforeEach, vi } from "vitest";
+import { loadLayout, getLayout, clearLayout, validateRegion, validateOverlay, MAX_REGIONS } from "../index.js";
+import type { LayoutRegion, LayoutOverlay } from "../index.js";
+import { readFile } from "node:fs/promises";
+import { existsSync } from "node:fs";
+
+vi.mock("node:fs/promises");
+vi.mock("node:fs");
+
+const clock: LayoutRegion = {
+  name: "clock",
+  x: 600,
+  y: 0,
+  width: 200,
+  height: 56,
+  template: "clock.html",
+  interval_sec: 60,
+};
+
+const time: LayoutOverlay = { x: 600, y: 424, width: 200, height: 56, font: 24, format: "%H:%M", align: "right" };
+
+describe("layout", () => {
+  beforeEach(() => {
+    clearLayout();
+    vi.resetAllMocks();
+  });
+
+  describe("validateRegion", () => {
+    it("should accept a byte-aligned region inside the display", () => {
+      expect(validateRegion(clock)).toBeNull();
+      expect(validateRegion({ ...clock, interval_sec: 65535 })).toBeNull();
+    });
+
+    it("should reject regions the device cannot draw", () => {
+      expect(validateRegion({ ...clock, x: 604 })).toMatch(/multiples of 8/);
+      expect(validateRegion({ ...clock, width: 100 })).toMatch(/multiples of 8/);
+      expect(validateRegion({ ...clock, y: 450 })).toMatch(/within/);
+      expect(validateRegion({ ...clock, interval_sec: 0 })).toMatch(/interval_sec/);
+      // A daily interval would wrap in the firmware's 16-bit field
+      expect(validateRegion({ ...clock, interval_sec: 86400 })).toMatch(/interval_sec/);
+      expect(validateRegion({ ...clock, template: "" })).toMatch(/template/);
+    });
+  });
+
+  describe("validateOverlay", () => {
+    it("should accept a byte-aligned overlay with a bundled font", () => {
+      expect(validateOverlay(time)).toBeNull();
+    });
+
+    it("should reject overlays the device cannot draw", () => {
+      expect(validateOverlay({ ...time, font: 14 })).toMatch(/font/);
+      expect(validateOverlay({ ...time, format: "" })).toMatch(/format/);
+      expect(validateOverlay({ ...time, x: 601 })).toMatch(/multiples of 8/);
+      expect(validateOverlay({ ...time, align: "middle" as "center" })).toMatch(/align/);
+    });
+  });
+
+  describe("loadLayout", () => {
+    it("should load valid regions and skip invalid ones", async () => {
+      vi.mocked(existsSync).mockReturnValue(true);
+      vi.mocked(readFile).mockResolvedValue(
+        JSON.stringify({ version: "1.0", regions: [clock, { ...clock, name: "bad", x: 3 }] })
+      );
+
+      const layout = await loadLayout();
+
+      expect(layout.regions).toEqual([clock]);
+      expect(getLayout().regions).toEqual([clock]);
+    });
+
+    it("should load overlays with the device clock settings", async () => {
+      vi.mocked(existsSync).mockReturnValue(true);
+      vi.mocked(readFile).mockResolvedValue(
+        JSON.stringify({ version: "1.0", overlays: [time], time: { timezone: "EET-2EEST,M3.5.0/3,M10.5.0/4" } })
+      );
+
+      const layout = await loadLayout();
+
+      expect(layout.regions).toEqual([]);
+      expect(layout.overlays).toEqual([time]);
+      expect(layout.time).toEqual({ timezone: "EET-2EEST,M3.5.0/3,M10.5.0/4", ntp_server: "pool.ntp.org" });
+    });
+
+    it("should use no regions or overlays when no file exists", async () => {
+      vi.mocked(existsSync).mockReturnValue(false);
+
+      const layout = await loadLayout();
+
+      expect(layout.regions).toEqual([]);
+      expect(layout.overlays).toEqual([]);
+    });
+
+    it("should keep at most MAX_REGIONS regions", async () => {
+      vi.mocked(existsSync).mockReturnValue(true);
+      const regions = Array.from({ length: MAX_REGIONS + 2 }, (_, i) => ({ ...clock, name: `r${i}` }));
+      vi.mocked(readFile).mockResolvedValue(JSON.stringify({ version: "1.0", regions }));
+
+      expect((await loadLayout()).regions).toHaveLength(MAX_REGIONS);
+    });
+  });
+});
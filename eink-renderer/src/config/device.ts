@@ -0,0 +1,112 @@
+/**
+ * Per-device config policy
+ *
+ * Devices describe themselves in the query of their /config request; the
+ * answer picks the transfer format, render size and refresh policy that
+ * board handles best. Requests without capabilities (older firmware) get
+ * the fleet defaults.
+ */
+
+/** 1-bit formats the firmware can draw */
+export type DeviceFormat = "rle" | "epd1" | "bmp";
+
+/** What a device reports about itself */
+export interface DeviceCapabilities {
+  /** GxEPD2 panel class, e.g. "GxEPD2_750_GDEY075T7" */
+  panel: string;
+  width: number;
+  height: number;
+  /** Free heap and PSRAM in bytes at the time of the request */
+  freeHeap: number;
+  psram: number;
+  formats: DeviceFormat[];
+  /** Panel has a fast partial waveform */
+  partialRefresh: boolean;
+  /** Battery unit that deep sleeps between refreshes */
+  deepSleep: boolean;
+  firmware: string;
+}
+
+/** What the device is told to do */
+export interface DevicePolicy {
+  format: DeviceFormat;
+  stream: boolean;
+  width: number;
+  height: number;
+  refreshIntervalSec: number;
+  /** Fast partial refreshes before a full one, 0 for full refreshes only; undefined leaves the firmware default */
+  partialRefreshCycles?: number;
+  fullRefreshMinutes?: number;
+  /** Long-poll, layout regions and overlays need a device that stays awake */
+  stayAwakeFeatures: boolean;
+}
+
+/** Fastest first: PackBits is the smallest body and is expanded in the band buffer */
+const FORMAT_PREFERENCE: DeviceFormat[] = ["rle", "epd1", "bmp"];
+
+const MAX_DIMENSION = 2048;
+
+export const DEFAULT_POLICY: DevicePolicy = {
+  format: "bmp",
+  stream: true,
+  width: 800,
+  height: 480,
+  refreshIntervalSec: 300,
+  stayAwakeFeatures: true,
+};
+
+function nonNegativeInt(value: string | undefined): number {
+  const parsed = Number(value);
+  return Number.isInteger(parsed) && parsed >= 0 ? parsed : 0;
+}
+
+/**
+ * Read the capabilities from /config query parameters
+ * @returns null if the device sent none
+ */
+export function parseCapabilities(params: Record<string, string>): DeviceCapabilities | null {
+  if (params.formats === undefined) {
+    return null;
+  }
+
+  const formats = params.formats
+    .split(",")
+    .map((format) => format.trim().toLowerCase())
+    .filter((format): format is DeviceFormat => FORMAT_PREFERENCE.includes(format as DeviceFormat));
+
+  return {
+    panel: params.panel ?? "",
+    width: nonNegativeInt(params.width),
+    height: nonNegativeInt(params.height),
+    freeHeap: nonNegativeInt(params.heap),
+    psram: nonNegativeInt(params.psram),
+    formats,
+    partialRefresh: params.partial === "1",
+    deepSleep: params.sleep === "1",
+    firmware: params.fw ?? "",
+  };
+}
+
+/**
+ * Pick format, render size and refresh policy for a device
+ * Render size follows the panel when it is one the firmware can address (width a multiple of 8)
+ */
+export function choosePolicy(capabilities: DeviceCapabilities | null): DevicePolicy {
+  if (!capabilities) {
+    return DEFAULT_POLICY;
+  }
+
+  const { width, height } = capabilities;
+  const sizeValid = width > 0 && height > 0 && width % 8 === 0 && width <= MAX_DIMENSION && height <= MAX_DIMENSION;
+
+  return {
+    format: FORMAT_PREFERENCE.find((format) => capabilities.formats.includes(format)) ?? DEFAULT_POLICY.format,
+    stream: true,
+    width: sizeValid ? width : DEFAULT_POLICY.width,
+    height: sizeValid ? height : DEFAULT_POLICY.height,
+    refreshIntervalSec: DEFAULT_POLICY.refreshIntervalSec,
+    partialRefreshCycles: capabilities.partialRefresh ? 10 : 0,
+    fullRefreshMinutes: capabilities.partialRefresh ? 60 : 0,
+    stayAwakeFeatures: !capabilities.deepSleep,
+  };
+}
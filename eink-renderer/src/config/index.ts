@@ -17,3 +17,19 @@ export {
   clearEntityMappings,
 } from "./entity-mappings.js";
 export type { EntityMappingsConfig } from "./entity-mappings.js";
+
+// Export region layout
+export {
+  loadLayout,
+  getLayout,
+  clearLayout,
+  validateRegion,
+  validateOverlay,
+  MAX_REGIONS,
+  MAX_OVERLAYS,
+} from "./layout.js";
+export type { Layout, LayoutRegion, LayoutOverlay, LayoutTime, LayoutConfig } from "./layout.js";
+
+// Export per-device config policy
+export { parseCapabilities, choosePolicy, DEFAULT_POLICY } from "./device.js";
+export type { DeviceCapabilities, DevicePolicy, DeviceFormat } from "./device.js";
@@ -0,0 +1,204 @@
+import { readFile } from "node:fs/promises";
+import { existsSync } from "node:fs";
+
+/**
+ * A rectangle of the display that the device refreshes on its own schedule
+ * (e.g. a clock every minute over a dashboard refreshed every 30 minutes)
+ */
+export interface LayoutRegion {
+  name: string;
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+  template: string;
+  interval_sec: number;
+}
+
+/**
+ * Text the device renders itself from its own clock, e.g. the time,
+ * so minute-level updates cost no render and no transfer
+ */
+export interface LayoutOverlay {
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+  /** Point size of the device's FreeMonoBold font: 9, 12, 18 or 24 */
+  font: number;
+  /** strftime() format, e.g. "%H:%M" */
+  format: string;
+  align?: "left" | "center" | "right";
+}
+
+/** Device clock settings for the overlays */
+export interface LayoutTime {
+  /** POSIX TZ string, e.g. "EET-2EEST,M3.5.0/3,M10.5.0/4" */
+  timezone: string;
+  ntp_server: string;
+}
+
+export interface LayoutConfig {
+  version: string;
+  regions?: LayoutRegion[];
+  overlays?: LayoutOverlay[];
+  time?: Partial<LayoutTime>;
+}
+
+/** What /config publishes from the layout file */
+export interface Layout {
+  regions: LayoutRegion[];
+  overlays: LayoutOverlay[];
+  time: LayoutTime;
+}
+
+/** Display the regions are laid out on */
+const DISPLAY_WIDTH = 800;
+const DISPLAY_HEIGHT = 480;
+
+/** Most regions and overlays the firmware keeps (MAX_REGIONS / MAX_OVERLAYS in config.h) */
+export const MAX_REGIONS = 8;
+export const MAX_OVERLAYS = 4;
+
+const OVERLAY_FONTS = [9, 12, 18, 24];
+
+/** Longest region interval the firmware stores (LayoutRegion::intervalSec is 16 bits) */
+export const MAX_INTERVAL_SEC = 65535;
+
+const DEFAULT_TIME: LayoutTime = { timezone: "UTC0", ntp_server: "pool.ntp.org" };
+
+let cachedLayout: Layout | null = null;
+
+/**
+ * Keep the valid entries of a layout list, warning about the others
+ */
+function validEntries<T>(
+  entries: T[] | undefined,
+  kind: string,
+  max: number,
+  validate: (entry: T) => string | null
+): T[] {
+  if (entries === undefined) {
+    return [];
+  }
+  if (!Array.isArray(entries)) {
+    console.warn(`Invalid layout: '${kind}s' must be an array`);
+    return [];
+  }
+
+  const valid = entries.filter((entry, index) => {
+    const problem = validate(entry);
+    if (problem) {
+      console.warn(`Skipping layout ${kind} ${index}: ${problem}`);
+    }
+    return !problem;
+  });
+
+  if (valid.length > max) {
+    console.warn(`Layout has ${valid.length} ${kind}s, only the first ${max} are used`);
+  }
+  return valid.slice(0, max);
+}
+
+/**
+ * Load the region and overlay layout from configuration file
+ * Supports both /data/layout.json (production) and
+ * ./config/layout.json (development)
+ * Without a file there are no regions or overlays and the device refreshes the whole image only
+ */
+export async function loadLayout(): Promise<Layout> {
+  if (cachedLayout) {
+    return cachedLayout;
+  }
+
+  const paths = ["/data/layout.json", "./config/layout.json"];
+
+  for (const path of paths) {
+    if (existsSync(path)) {
+      try {
+        const content = await readFile(path, "utf-8");
+        const config: LayoutConfig = JSON.parse(content);
+
+        cachedLayout = {
+          regions: validEntries(config.regions, "region", MAX_REGIONS, validateRegion),
+          overlays: validEntries(config.overlays, "overlay", MAX_OVERLAYS, validateOverlay),
+          time: { ...DEFAULT_TIME, ...config.time },
+        };
+        console.info(
+          `Loaded ${cachedLayout.regions.length} region(s) and ${cachedLayout.overlays.length} overlay(s) from ${path}`
+        );
+        return cachedLayout;
+      } catch (error) {
+        console.warn(`Failed to load layout from ${path}:`, error);
+      }
+    }
+  }
+
+  cachedLayout = { regions: [], overlays: [], time: { ...DEFAULT_TIME } };
+  return cachedLayout;
+}
+
+/**
+ * Get cached layout (empty if no layout was loaded)
+ */
+export function getLayout(): Layout {
+  return cachedLayout ?? { regions: [], overlays: [], time: { ...DEFAULT_TIME } };
+}
+
+/**
+ * Clear cached layout (useful for testing)
+ */
+export function clearLayout(): void {
+  cachedLayout = null;
+}
+
+/**
+ * x and width must be multiples of 8 so rows start on a byte of panel RAM
+ */
+function validateRect(rect: { x: number; y: number; width: number; height: number }): string | null {
+  const { x, y, width, height } = rect;
+  if (![x, y, width, height].every(Number.isInteger)) {
+    return "x, y, width and height must be integers";
+  }
+  if (x % 8 !== 0 || width % 8 !== 0) {
+    return "x and width must be multiples of 8";
+  }
+  if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > DISPLAY_WIDTH || y + height > DISPLAY_HEIGHT) {
+    return `rectangle must lie within ${DISPLAY_WIDTH}x${DISPLAY_HEIGHT}`;
+  }
+  return null;
+}
+
+/**
+ * Check a region against what the device can draw
+ * @returns Reason the region is unusable, or null if it is valid
+ */
+export function validateRegion(region: LayoutRegion): string | null {
+  if (!region || typeof region.name !== "string" || region.name.length === 0) {
+    return "missing name";
+  }
+  if (typeof region.template !== "string" || region.template.length === 0) {
+    return "missing template";
+  }
+  if (!Number.isInteger(region.interval_sec) || region.interval_sec < 1 || region.interval_sec > MAX_INTERVAL_SEC) {
+    return `interval_sec must be between 1 and ${MAX_INTERVAL_SEC}`;
+  }
+  return validateRect(region);
+}
+
+/**
+ * Check an overlay against what the device can draw
+ * @returns Reason the overlay is unusable, or null if it is valid
+ */
+export function validateOverlay(overlay: LayoutOverlay): string | null {
+  if (!overlay || typeof overlay.format !== "string" || overlay.format.length === 0) {
+    return "missing format";
+  }
+  if (!OVERLAY_FONTS.includes(overlay.font)) {
+    return `font must be one of ${OVERLAY_FONTS.join(", ")}`;
+  }
+  if (overlay.align !== undefined && !["left", "center", "right"].includes(overlay.align)) {
+    return "align must be left, center or right";
+  }
+  return validateRect(overlay);
+}
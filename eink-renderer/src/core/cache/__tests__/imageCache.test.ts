@@ -0,0 +1,161 @@
+import { describe, it, expect, beforeEach, vi } from "vitest";
+import { imageCache } from "../index.js";
+
+const key = imageCache.buildKey({
+  source: "template:dashboard.html",
+  width: 800,
+  height: 480,
+  threshold: 128,
+  format: "bmp",
+});
+
+function image(byte: number) {
+  return { data: Buffer.alloc(16, byte), etag: `"${byte}"` };
+}
+
+describe("imageCache", () => {
+  beforeEach(() => {
+    imageCache.clear();
+    imageCache.setMaxSize(20);
+  });
+
+  describe("buildKey", () => {
+    it("should give different keys for different render parameters", () => {
+      const base = { source: "url:http://a", width: 800, height: 480, threshold: 128, format: "bmp" };
+
+      expect(imageCache.buildKey(base)).toBe(imageCache.buildKey({ ...base }));
+      expect(imageCache.buildKey({ ...base, threshold: 100 })).not.toBe(imageCache.buildKey(base));
+      expect(imageCache.buildKey({ ...base, format: "rle" })).not.toBe(imageCache.buildKey(base));
+      expect(imageCache.buildKey({ ...base, width: 640 })).not.toBe(imageCache.buildKey(base));
+      expect(imageCache.buildKey({ ...base, quality: 80 })).not.toBe(imageCache.buildKey(base));
+      expect(imageCache.buildKey({ ...base, dither: "ordered" })).not.toBe(imageCache.buildKey(base));
+      expect(imageCache.buildKey({ ...base, dither: "none" })).toBe(imageCache.buildKey(base));
+    });
+  });
+
+  describe("set and get", () => {
+    it("should store and retrieve an encoded image", () => {
+      imageCache.set(key, image(1), 30, "template:dashboard.html");
+
+      expect(imageCache.get(key)).toEqual(image(1));
+    });
+
+    it("should return null for expired entry", () => {
+      vi.useFakeTimers();
+
+      imageCache.set(key, image(1), 5, "template:dashboard.html");
+      vi.advanceTimersByTime(6000);
+
+      expect(imageCache.get(key)).toBeNull();
+
+      vi.useRealTimers();
+    });
+
+    it("should not store anything with a TTL of 0", () => {
+      imageCache.set(key, image(1), 0, "template:dashboard.html");
+
+      expect(imageCache.get(key)).toBeNull();
+    });
+  });
+
+  describe("getOrRender", () => {
+    it("should render once and serve later requests from the cache", async () => {
+      const render = vi.fn(async () => image(2));
+
+      const first = await imageCache.getOrRender(key, "template:dashboard.html", 30, render);
+      const second = await imageCache.getOrRender(key, "template:dashboard.html", 30, render);
+
+      expect(render).toHaveBeenCalledTimes(1);
+      expect(second).toEqual(first);
+    });
+
+    it("should share one render between concurrent requests", async () => {
+      const render = vi.fn(async () => image(3));
+
+      const results = await Promise.all([
+        imageCache.getOrRender(key, "template:dashboard.html", 30, render),
+        imageCache.getOrRender(key, "template:dashboard.html", 30, render),
+        imageCache.getOrRender(key, "template:dashboard.html", 30, render),
+      ]);
+
+      expect(render).toHaveBeenCalledTimes(1);
+      expect(results[2]).toEqual(image(3));
+    });
+
+    it("should not cache a failed render", async () => {
+      const failing = vi.fn(async () => {
+        throw new Error("render failed");
+      });
+
+      await expect(imageCache.getOrRender(key, "template:dashboard.html", 30, failing)).rejects.toThrow(
+        "render failed"
+      );
+
+      const render = vi.fn(async () => image(4));
+      expect(await imageCache.getOrRender(key, "template:dashboard.html", 30, render)).toEqual(image(4));
+      expect(render).toHaveBeenCalledTimes(1);
+    });
+  });
+
+  describe("invalidate", () => {
+    it("should remove every entry rendered from a source", () => {
+      const rleKey = imageCache.buildKey({
+        source: "template:dashboard.html",
+        width: 800,
+        height: 480,
+        threshold: 128,
+        format: "rle",
+      });
+      imageCache.set(key, image(1), 30, "template:dashboard.html");
+      imageCache.set(rleKey, image(2), 30, "template:dashboard.html");
+      imageCache.set("other", image(3), 30, "template:other.html");
+
+      expect(imageCache.invalidate("template:dashboard.html")).toBe(2);
+      expect(imageCache.get(key)).toBeNull();
+      expect(imageCache.get("other")).not.toBeNull();
+    });
+
+    it("should keep a render started before the invalidation out of the cache", async () => {
+      let finish: (image: { data: Buffer; etag: string }) => void = () => {};
+      const stale = imageCache.getOrRender(
+        key,
+        "template:dashboard.html",
+        30,
+        () => new Promise((resolve) => (finish = resolve))
+      );
+
+      imageCache.invalidate("template:dashboard.html");
+
+      // Requests after the invalidation do not join the stale render
+      const render = vi.fn(async () => image(6));
+      const fresh = imageCache.getOrRender(key, "template:dashboard.html", 30, render);
+      finish(image(5));
+
+      expect(await stale).toEqual(image(5));
+      expect(await fresh).toEqual(image(6));
+      expect(render).toHaveBeenCalledTimes(1);
+      expect(imageCache.get(key)).toEqual(image(6));
+    });
+  });
+
+  describe("LRU eviction", () => {
+    it("should evict least recently used entry when cache is full", () => {
+      vi.useFakeTimers();
+
+      imageCache.setMaxSize(2);
+      imageCache.set("key1", image(1), 30, "a");
+      vi.advanceTimersByTime(1000);
+      imageCache.set("key2", image(2), 30, "b");
+      vi.advanceTimersByTime(1000);
+      imageCache.get("key1");
+      vi.advanceTimersByTime(1000);
+      imageCache.set("key3", image(3), 30, "c");
+
+      expect(imageCache.get("key2")).toBeNull();
+      expect(imageCache.get("key1")).not.toBeNull();
+      expect(imageCache.getStats().size).toBe(2);
+
+      vi.useRealTimers();
+    });
+  });
+});
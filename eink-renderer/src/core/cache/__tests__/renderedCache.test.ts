@@ -1,5 +1,5 @@
 import { describe, it, expect, beforeEach, vi } from "vitest";
-import { set, get, has, clear, getStats, setMaxSize, keys } from "../index.js";
+import { set, get, has, remove, clear, getStats, setMaxSize, keys } from "../index.js";
 
 describe("renderedCache", () => {
   beforeEach(() => {
@@ -95,6 +95,18 @@ describe("renderedCache", () => {
     });
   });
 
+  describe("remove", () => {
+    it("should remove only the given entry", () => {
+      set("key1", "<html>1</html>", 300, { templateName: "test1.html", entitiesFetched: 1 });
+      set("key2", "<html>2</html>", 300, { templateName: "test2.html", entitiesFetched: 2 });
+
+      expect(remove("key1")).toBe(true);
+      expect(remove("key1")).toBe(false);
+      expect(get("key1")).toBeNull();
+      expect(get("key2")).toBe("<html>2</html>");
+    });
+  });
+
   describe("clear", () => {
     it("should remove all entries", () => {
       set("key1", "<html>1</html>", 300, { templateName: "test1.html", entitiesFetched: 1 });
@@ -0,0 +1,224 @@
+/**
+ * Encoded image cache
+ *
+ * Holds the final encoded image of a render so the offset/limit chunk requests
+ * of one device refresh are served as slices of a single browser render.
+ */
+
+/** An encoded image as served by /image */
+export interface CachedImage {
+  data: Buffer | Uint8Array;
+  etag: string;
+}
+
+/** Everything that changes the encoded bytes */
+export interface ImageCacheKey {
+  /** "template:<name>" or "url:<url>", also used for invalidation */
+  source: string;
+  width: number;
+  height: number;
+  threshold: number;
+  /** Dither mode of 1-bit formats, "none" when unset */
+  dither?: string;
+  format: string;
+  quality?: number;
+}
+
+interface ImageCacheEntry extends CachedImage {
+  source: string;
+  cachedAt: number;
+  ttl: number;
+  lastAccessed: number;
+}
+
+interface PendingRender {
+  source: string;
+  promise: Promise<CachedImage>;
+}
+
+const cache = new Map<string, ImageCacheEntry>();
+const pending = new Map<string, PendingRender>();
+// Bumped by invalidate() so renders started before it are not cached
+const generations = new Map<string, number>();
+let maxSize = 20;
+
+/**
+ * Build the cache key string for a render
+ */
+export function buildKey(key: ImageCacheKey): string {
+  return [
+    key.source,
+    `${key.width}x${key.height}`,
+    key.threshold,
+    key.dither ?? "none",
+    key.format,
+    key.quality ?? "",
+  ].join("|");
+}
+
+/**
+ * Store an encoded image
+ * @param key Key from buildKey()
+ * @param image Encoded image and its ETag
+ * @param ttl Time-to-live in seconds (0 disables caching)
+ * @param source Source the image was rendered from, see ImageCacheKey
+ */
+export function set(key: string, image: CachedImage, ttl: number, source: string): void {
+  if (ttl <= 0) {
+    return;
+  }
+
+  // Evict if cache is full (LRU)
+  if (cache.size >= maxSize && !cache.has(key)) {
+    evictLRU();
+  }
+
+  const now = Date.now();
+  cache.set(key, { ...image, source, cachedAt: now, ttl, lastAccessed: now });
+}
+
+/**
+ * Get an encoded image (returns null if expired or not found)
+ */
+export function get(key: string): CachedImage | null {
+  const entry = cache.get(key);
+
+  if (!entry) {
+    return null;
+  }
+
+  if ((Date.now() - entry.cachedAt) / 1000 > entry.ttl) {
+    cache.delete(key);
+    return null;
+  }
+
+  entry.lastAccessed = Date.now();
+  return { data: entry.data, etag: entry.etag };
+}
+
+/**
+ * Return the cached image or render it once
+ * Concurrent requests for the same key wait for the same render. A render
+ * the source was invalidated during is returned but not cached.
+ * @param render Produces the encoded image on a miss; failures are not cached
+ */
+export function getOrRender(
+  key: string,
+  source: string,
+  ttl: number,
+  render: () => Promise<CachedImage>
+): Promise<CachedImage> {
+  const cached = get(key);
+  if (cached) {
+    return Promise.resolve(cached);
+  }
+
+  const inFlight = pending.get(key);
+  if (inFlight) {
+    return inFlight.promise;
+  }
+
+  const generation = generations.get(source) ?? 0;
+  const entry: PendingRender = {
+    source,
+    promise: render()
+      .then((image) => {
+        if ((generations.get(source) ?? 0) === generation) {
+          set(key, image, ttl, source);
+        }
+        return image;
+      })
+      .finally(() => {
+        // A render started after an invalidation may own the key by now
+        if (pending.get(key) === entry) {
+          pending.delete(key);
+        }
+      }),
+  };
+
+  pending.set(key, entry);
+  return entry.promise;
+}
+
+/**
+ * Drop every cached image rendered from a source (e.g. after the template was re-rendered)
+ * Renders of the source still running are not cached and no longer shared.
+ * @returns Number of entries removed
+ */
+export function invalidate(source: string): number {
+  generations.set(source, (generations.get(source) ?? 0) + 1);
+  for (const [key, render] of pending.entries()) {
+    if (render.source === source) {
+      pending.delete(key);
+    }
+  }
+
+  let removed = 0;
+  for (const [key, entry] of cache.entries()) {
+    if (entry.source === source) {
+      cache.delete(key);
+      removed++;
+    }
+  }
+  return removed;
+}
+
+/**
+ * Clear all cache entries
+ */
+export function clear(): void {
+  cache.clear();
+}
+
+/**
+ * Get cache statistics
+ */
+export function getStats(): {
+  size: number;
+  maxSize: number;
+  entries: Array<{ key: string; source: string; age: number; size: number }>;
+} {
+  const entries = Array.from(cache.entries()).map(([key, entry]) => ({
+    key,
+    source: entry.source,
+    age: Math.floor((Date.now() - entry.cachedAt) / 1000),
+    size: entry.data.length,
+  }));
+
+  return {
+    size: cache.size,
+    maxSize,
+    entries,
+  };
+}
+
+/**
+ * Set maximum cache size
+ * @param size Maximum number of entries
+ */
+export function setMaxSize(size: number): void {
+  maxSize = size;
+
+  while (cache.size > maxSize) {
+    evictLRU();
+  }
+}
+
+/**
+ * Evict least recently used entry
+ */
+function evictLRU(): void {
+  let lruKey: string | null = null;
+  let lruTime = Infinity;
+
+  for (const [key, entry] of cache.entries()) {
+    if (entry.lastAccessed < lruTime) {
+      lruTime = entry.lastAccessed;
+      lruKey = key;
+    }
+  }
+
+  if (lruKey) {
+    cache.delete(lruKey);
+  }
+}
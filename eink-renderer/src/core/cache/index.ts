@@ -2,4 +2,5 @@
  * Cache module barrel export
  */
 
-export { set, get, has, clear, getStats, setMaxSize, keys } from "./renderedCache.js";
+export { set, get, has, remove, clear, getStats, setMaxSize, keys } from "./renderedCache.js";
+export * as imageCache from "./imageCache.js";
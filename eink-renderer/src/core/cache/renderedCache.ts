@@ -73,6 +73,15 @@ export function has(key: string): boolean {
   return get(key) !== null;
 }
 
+/**
+ * Remove one cache entry
+ * @param key Cache key
+ * @returns True if an entry was removed
+ */
+export function remove(key: string): boolean {
+  return cache.delete(key);
+}
+
 /**
  * Clear all cache entries
  */
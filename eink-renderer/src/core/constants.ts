@@ -8,5 +8,14 @@ export const BASE_HOST = process.env.BASE_HOST || "localhost";
 /** Base port for server binding */
 export const BASE_PORT = parseInt(process.env.BASE_PORT || "8000", 10);
 
+/** URL devices are told to use in /config, e.g. "https://renderer.example.com"; derived from the request if unset */
+export const PUBLIC_URL = (process.env.PUBLIC_URL || "").replace(/\/+$/, "");
+
 /** Active template ID used in config endpoint */
 export const ACTIVE_TEMPLATE_ID = process.env.ACTIVE_TEMPLATE || "dashboard-full.html";
+
+/** Seconds an encoded /image result is reused for chunk requests and revalidation (0 disables) */
+export const IMAGE_CACHE_TTL = parseInt(process.env.IMAGE_CACHE_TTL || "30", 10);
+
+/** Dither mode of 1-bit /image formats without a dither parameter: none, ordered or floyd-steinberg */
+export const IMAGE_DITHER = process.env.IMAGE_DITHER || "none";
@@ -0,0 +1,22 @@
+import { createHash } from "crypto";
+
+/**
+ * Strong ETag for a response body (first 16 hex chars of its SHA-1)
+ */
+export function computeEtag(body: Buffer | Uint8Array | string): string {
+  return `"${createHash("sha1").update(body).digest("hex").slice(0, 16)}"`;
+}
+
+/**
+ * Check an If-None-Match header against an ETag ("*", weak tags and lists allowed)
+ */
+export function etagMatches(ifNoneMatch: string | undefined, etag: string): boolean {
+  if (!ifNoneMatch) {
+    return false;
+  }
+
+  return ifNoneMatch
+    .split(",")
+    .map((tag) => tag.trim().replace(/^W\//, ""))
+    .some((tag) => tag === etag || tag === "*");
+}
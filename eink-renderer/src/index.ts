@@ -1,5 +1,5 @@
 import { createServer } from "./server/index.js";
-import { loadConfig, loadEntityMappings } from "./config/index.js";
+import { loadConfig, loadEntityMappings, loadLayout } from "./config/index.js";
 import { getTemplatesDir, listTemplates } from "./templates/index.js";
 import { mkdir } from "node:fs/promises";
 import { existsSync } from "node:fs";
@@ -45,6 +45,15 @@ async function initializeHA() {
 // Initialize
 await initializeHA();
 
+// Region layout is optional and independent of Home Assistant
+const layout = await loadLayout();
+if (layout.regions.length > 0) {
+  console.log(`✓ Layout: ${layout.regions.map((r) => `${r.name} (${r.interval_sec}s)`).join(", ")}`);
+}
+if (layout.overlays.length > 0) {
+  console.log(`✓ Overlays: ${layout.overlays.map((o) => `"${o.format}"`).join(", ")} (${layout.time.timezone})`);
+}
+
 const { server, browserManager } = createServer();
 
 server.listen(BASE_PORT, () => {
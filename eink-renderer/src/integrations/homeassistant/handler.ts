@@ -4,6 +4,7 @@ import { extractEntityIds, extractCalendarIds, renderTemplate } from "../../temp
 import { getMultipleStates, getCalendarEvents } from "./client.js";
 import type { CalendarEvent } from "./types.js";
 import * as renderedCache from "../../core/cache/index.js";
+import { imageCache } from "../../core/cache/index.js";
 import { getConfig } from "../../config/index.js";
 
 interface RenderResult {
@@ -172,6 +173,9 @@ export async function handleRender(
       entitiesFetched: entityIds.length,
     });
 
+    // Images encoded from the previous HTML are stale now
+    imageCache.invalidate(`template:${templateName}`);
+
     // Return HTML directly if format=html
     if (format === "html") {
       res.writeHead(200, { "Content-Type": "text/html; charset=utf-8" });
@@ -0,0 +1,105 @@
+import { describe, it, expect } from "vitest";
+import { decodePackBits, encodeBmp, encodePackBits, toMonochrome } from "../bitmap.js";
+
+function solidRgba(width: number, height: number, value: number): Buffer {
+  return Buffer.alloc(width * height * 4, value);
+}
+
+describe("bitmap", () => {
+  describe("toMonochrome", () => {
+    it("should pack white pixels as 1 bits, MSB first", () => {
+      const rgba = solidRgba(16, 2, 255);
+      // Make the first pixel of the second row black
+      rgba.fill(0, 16 * 4, 16 * 4 + 3);
+
+      const bitmap = toMonochrome(rgba, 16, 2, 128);
+
+      expect(bitmap.bytesPerRow).toBe(2);
+      expect([...bitmap.data]).toEqual([0xff, 0xff, 0x7f, 0xff]);
+    });
+
+    it("should pad partial bytes at the end of a row with zeros", () => {
+      const bitmap = toMonochrome(solidRgba(10, 1, 255), 10, 1, 128);
+
+      expect(bitmap.bytesPerRow).toBe(2);
+      expect([...bitmap.data]).toEqual([0xff, 0xc0]);
+    });
+
+    it("should apply the threshold to luminance", () => {
+      const gray = solidRgba(8, 1, 100);
+
+      expect(toMonochrome(gray, 8, 1, 50).data[0]).toBe(0xff);
+      expect(toMonochrome(gray, 8, 1, 200).data[0]).toBe(0x00);
+    });
+  });
+
+  describe("dithering", () => {
+    function whiteRatio(data: Buffer): number {
+      let white = 0;
+      for (const byte of data) {
+        for (let bit = 0; bit < 8; bit++) {
+          white += (byte >> bit) & 1;
+        }
+      }
+      return white / (data.length * 8);
+    }
+
+    it.each(["ordered", "floyd-steinberg"] as const)("should draw gray levels as %s dot patterns", (dither) => {
+      expect(whiteRatio(toMonochrome(solidRgba(64, 64, 64), 64, 64, 128, dither).data)).toBeCloseTo(0.25, 1);
+      expect(whiteRatio(toMonochrome(solidRgba(64, 64, 128), 64, 64, 128, dither).data)).toBeCloseTo(0.5, 1);
+      expect(whiteRatio(toMonochrome(solidRgba(64, 64, 192), 64, 64, 128, dither).data)).toBeCloseTo(0.75, 1);
+    });
+
+    it.each(["ordered", "floyd-steinberg"] as const)("should keep white and black solid with %s", (dither) => {
+      expect(toMonochrome(solidRgba(16, 16, 255), 16, 16, 128, dither).data.every((byte) => byte === 0xff)).toBe(true);
+      expect(toMonochrome(solidRgba(16, 16, 0), 16, 16, 128, dither).data.every((byte) => byte === 0x00)).toBe(true);
+    });
+
+    it("should pad partial bytes when dithering", () => {
+      for (const dither of ["ordered", "floyd-steinberg"] as const) {
+        expect([...toMonochrome(solidRgba(10, 1, 255), 10, 1, 128, dither).data]).toEqual([0xff, 0xc0]);
+      }
+    });
+  });
+
+  describe("encodeBmp", () => {
+    it("should produce a 62-byte header followed by 4-byte padded rows", () => {
+      const bitmap = toMonochrome(solidRgba(10, 3, 255), 10, 3, 128);
+      const bmp = encodeBmp(bitmap);
+
+      expect(bmp.toString("ascii", 0, 2)).toBe("BM");
+      expect(bmp.readUInt32LE(10)).toBe(62);
+      expect(bmp.readInt32LE(22)).toBe(-3);
+      expect(bmp.length).toBe(62 + 4 * 3);
+      expect([...bmp.subarray(62, 66)]).toEqual([0xff, 0xc0, 0, 0]);
+    });
+  });
+
+  describe("PackBits", () => {
+    it("should round-trip mixed runs and literals", () => {
+      const input = Buffer.from([1, 2, 3, 3, 3, 4, 5, 5, 6, 7, 7, 7, 7]);
+
+      expect(decodePackBits(encodePackBits(input))).toEqual(input);
+    });
+
+    it("should compress a blank 800x480 frame to a small fraction", () => {
+      const blank = Buffer.alloc(48000, 0xff);
+      const encoded = encodePackBits(blank);
+
+      expect(encoded.length).toBe(750);
+      expect(decodePackBits(encoded)).toEqual(blank);
+    });
+
+    it("should split long literals into blocks of at most 128 bytes", () => {
+      const input = Buffer.from(Array.from({ length: 300 }, (_, i) => i % 251));
+      const encoded = encodePackBits(input);
+
+      expect(encoded[0]).toBe(127);
+      expect(decodePackBits(encoded)).toEqual(input);
+    });
+
+    it("should handle empty input", () => {
+      expect(encodePackBits(Buffer.alloc(0)).length).toBe(0);
+    });
+  });
+});
@@ -0,0 +1,115 @@
+import { describe, it, expect, beforeEach, vi } from "vitest";
+import http from "http";
+import { URL } from "url";
+import { Jimp } from "jimp";
+import type { Browser } from "puppeteer";
+import { createImageRequestHandler, type BrowserManager } from "../index.js";
+import * as renderedCache from "../../core/cache/index.js";
+import { imageCache } from "../../core/cache/index.js";
+import { waitForChange, clear as clearWatcher } from "../../changes/index.js";
+import type { WatchSource } from "../../changes/index.js";
+import type { EntityState } from "../../integrations/homeassistant/index.js";
+
+const ha = vi.hoisted(() => ({ state: "off" }));
+
+function entity(state: string): EntityState {
+  return {
+    entity_id: "sensor.test",
+    state,
+    attributes: {},
+    last_changed: new Date().toISOString(),
+    last_updated: new Date().toISOString(),
+  };
+}
+
+vi.mock("../../integrations/homeassistant/index.js", () => ({
+  getMultipleStates: vi.fn(async () => ({ sensor_test: entity(ha.state) })),
+  getCalendarEvents: vi.fn(async () => []),
+}));
+
+vi.mock("../../templates/index.js", () => ({
+  loadTemplate: vi.fn(async () => "<p>{{ sensor_test.state }}</p>"),
+  templateExists: vi.fn(() => true),
+  extractEntityIds: vi.fn(() => ["sensor.test"]),
+  extractCalendarIds: vi.fn(() => []),
+  renderTemplate: vi.fn(
+    (_html: string, entities: Record<string, EntityState | null>) => `<p>${entities.sensor_test?.state}</p>`
+  ),
+}));
+
+// Browser whose screenshot is white when the page says "on", black otherwise
+function fakeBrowserManager(): BrowserManager {
+  let html = "";
+  const page = {
+    setViewport: async () => {},
+    setContent: async (content: string) => {
+      html = content;
+    },
+    screenshot: async () => {
+      const color = html.includes("on") ? 0xffffffff : 0x000000ff;
+      return new Jimp({ width: 16, height: 8, color }).getBuffer("image/png");
+    },
+    close: async () => {},
+  };
+  const browser = { newPage: async () => page } as unknown as Browser;
+  return { getBrowser: async () => browser, close: async () => {} };
+}
+
+const watchSource: WatchSource = {
+  entityIds: async () => ["sensor.test"],
+  states: async () => ({ sensor_test: entity(ha.state) }),
+  pollIntervalMs: 10,
+};
+
+function requestImage(
+  handler: ReturnType<typeof createImageRequestHandler>,
+  headers: http.IncomingHttpHeaders = {}
+): Promise<{ statusCode: number; etag: string; data: Buffer }> {
+  return new Promise((resolve, reject) => {
+    let statusCode = 0;
+    let etag = "";
+    const res = {
+      writeHead(code: number, responseHeaders: Record<string, string> = {}) {
+        statusCode = code;
+        etag = responseHeaders.ETag ?? "";
+      },
+      end(body?: Buffer | Uint8Array) {
+        resolve({ statusCode, etag, data: Buffer.from(body ?? []) });
+      },
+    } as unknown as http.ServerResponse;
+
+    const params = { template: "test.html", format: "epd1", width: "16", height: "8" };
+    handler(new URL("http://localhost/image"), params, res, headers).catch(reject);
+  });
+}
+
+describe("image handler", () => {
+  beforeEach(() => {
+    ha.state = "off";
+    renderedCache.clear();
+    imageCache.clear();
+    clearWatcher();
+  });
+
+  it("should serve the new frame once a watched entity has changed", async () => {
+    const handler = createImageRequestHandler(fakeBrowserManager());
+    const before = await waitForChange("test.html", undefined, 0, undefined, watchSource);
+
+    const first = await requestImage(handler);
+    expect(first.statusCode).toBe(200);
+    expect([...first.data]).toEqual(new Array(16).fill(0x00));
+
+    // Unchanged states: the cached frame revalidates
+    expect((await requestImage(handler, { "if-none-match": first.etag })).statusCode).toBe(304);
+
+    // The device is woken by /changes and asks again with the frame it shows
+    ha.state = "on";
+    const change = await waitForChange("test.html", before.token, 5000, undefined, watchSource);
+    expect(change.changed).toBe(true);
+
+    const second = await requestImage(handler, { "if-none-match": first.etag });
+    expect(second.statusCode).toBe(200);
+    expect(second.etag).not.toBe(first.etag);
+    expect([...second.data]).toEqual(new Array(16).fill(0xff));
+  });
+});
@@ -0,0 +1,81 @@
+import { describe, it, expect } from "vitest";
+import { deflateSync } from "node:zlib";
+import { Jimp } from "jimp";
+import { decodePng } from "../png.js";
+
+const SIGNATURE = Buffer.from([0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a]);
+
+// The decoder does not check CRCs, so chunks are written with a zero CRC
+function chunk(type: string, body: Buffer): Buffer {
+  const length = Buffer.alloc(4);
+  length.writeUInt32BE(body.length);
+  return Buffer.concat([length, Buffer.from(type, "latin1"), body, Buffer.alloc(4)]);
+}
+
+// 8-bit RGB PNG with unfiltered rows, its IDAT split in two
+function rgbPng(width: number, height: number, pixels: Buffer): Buffer {
+  const header = Buffer.alloc(13);
+  header.writeUInt32BE(width, 0);
+  header.writeUInt32BE(height, 4);
+  header[8] = 8;
+  header[9] = 2;
+
+  const raw = Buffer.alloc((width * 3 + 1) * height);
+  for (let y = 0; y < height; y++) {
+    pixels.copy(raw, y * (width * 3 + 1) + 1, y * width * 3, (y + 1) * width * 3);
+  }
+  const compressed = deflateSync(raw);
+  const half = compressed.length >> 1;
+
+  return Buffer.concat([
+    SIGNATURE,
+    chunk("IHDR", header),
+    chunk("IDAT", compressed.subarray(0, half)),
+    chunk("IDAT", compressed.subarray(half)),
+    chunk("IEND", Buffer.alloc(0)),
+  ]);
+}
+
+async function noisePng(width: number, height: number): Promise<Buffer> {
+  const image = new Jimp({ width, height, color: 0xffffffff });
+  const data = image.bitmap.data;
+  for (let i = 0; i < data.length; i++) {
+    data[i] = (i * 7919 + ((i * i) >> 3)) & 0xff;
+  }
+  return image.getBuffer("image/png");
+}
+
+describe("decodePng", () => {
+  it("should match Jimp on an RGBA PNG using every row filter", async () => {
+    const png = await noisePng(37, 23);
+
+    const image = decodePng(png);
+    const reference = (await Jimp.read(png)).bitmap;
+
+    expect(image).not.toBeNull();
+    expect(image!.width).toBe(37);
+    expect(image!.height).toBe(23);
+    expect(Buffer.from(image!.data)).toEqual(reference.data);
+  });
+
+  it("should expand RGB to opaque RGBA across IDAT chunks", () => {
+    const pixels = Buffer.from([255, 0, 0, 0, 255, 0, 0, 0, 255, 10, 20, 30]);
+
+    const image = decodePng(rgbPng(2, 2, pixels));
+
+    expect([...image!.data]).toEqual([255, 0, 0, 255, 0, 255, 0, 255, 0, 0, 255, 255, 10, 20, 30, 255]);
+  });
+
+  it("should leave unsupported and malformed files to the caller", async () => {
+    const png = await noisePng(8, 8);
+    const palette = Buffer.from(png);
+    palette[25] = 3; // IHDR color type
+    const interlaced = Buffer.from(png);
+    interlaced[28] = 1; // IHDR interlace method
+
+    expect(decodePng(palette)).toBeNull();
+    expect(decodePng(interlaced)).toBeNull();
+    expect(decodePng(Buffer.from("not a png"))).toBeNull();
+    expect(decodePng(png.subarray(0, png.length - 40))).toBeNull();
+  });
+});
@@ -0,0 +1,283 @@
+/**
+ * 1-bit bitmap encoders for e-ink devices
+ */
+
+/** Packed 1-bit image: top-down rows, MSB first, 1 = white, no row padding */
+export interface MonochromeBitmap {
+  width: number;
+  height: number;
+  bytesPerRow: number;
+  data: Buffer;
+}
+
+/** How gray levels become black and white pixels */
+export const DITHER_MODES = ["none", "ordered", "floyd-steinberg"] as const;
+export type DitherMode = (typeof DITHER_MODES)[number];
+
+/** 8x8 Bayer matrix, values 0-63 */
+const BAYER_8X8 = [
+  0, 32, 8, 40, 2, 34, 10, 42, 48, 16, 56, 24, 50, 18, 58, 26, 12, 44, 4, 36, 14, 46, 6, 38, 60, 28, 52, 20, 62, 30, 54,
+  22, 3, 35, 11, 43, 1, 33, 9, 41, 51, 19, 59, 27, 49, 17, 57, 25, 15, 47, 7, 39, 13, 45, 5, 37, 63, 31, 55, 23, 61, 29,
+  53, 21,
+];
+
+/**
+ * Threshold every pixel against a level from an 8x8 tile, packing 8 pixels per byte
+ * Luminance is in thousandths (integer Rec. 601 weights), so a level of
+ * threshold * 1000 matches the float threshold exactly
+ */
+function packThresholded(
+  rgba: Buffer | Uint8Array,
+  width: number,
+  height: number,
+  bytesPerRow: number,
+  levels: Int32Array
+): Buffer {
+  const data = Buffer.alloc(bytesPerRow * height);
+  let idx = 0;
+  let out = 0;
+
+  for (let y = 0; y < height; y++) {
+    const tileRow = (y & 7) << 3;
+    let currentByte = 0;
+    let x = 0;
+
+    for (; x < width; x++, idx += 4) {
+      const luma = 299 * rgba[idx]! + 587 * rgba[idx + 1]! + 114 * rgba[idx + 2]!;
+      currentByte = (currentByte << 1) | (luma >= levels[tileRow | (x & 7)]! ? 1 : 0);
+      if ((x & 7) === 7) {
+        data[out++] = currentByte;
+        currentByte = 0;
+      }
+    }
+
+    // Pad a partial last byte with zeros
+    if ((x & 7) !== 0) {
+      data[out++] = currentByte << (8 - (x & 7));
+    }
+  }
+
+  return data;
+}
+
+/**
+ * Floyd-Steinberg error diffusion, serpentine so errors do not drift to one side
+ * Each pixel is decided by the threshold as in plain thresholding
+ */
+function packDiffused(
+  rgba: Buffer | Uint8Array,
+  width: number,
+  height: number,
+  bytesPerRow: number,
+  threshold: number
+): Buffer {
+  const data = Buffer.alloc(bytesPerRow * height);
+  // Error in sixteenths carried into this row and the next, one pixel of margin each side
+  let current = new Int32Array(width + 2);
+  let next = new Int32Array(width + 2);
+
+  for (let y = 0; y < height; y++) {
+    const reverse = (y & 1) === 1;
+    const step = reverse ? -1 : 1;
+    const out = y * bytesPerRow;
+
+    for (let i = 0, x = reverse ? width - 1 : 0; i < width; i++, x += step) {
+      const idx = (y * width + x) * 4;
+      const luma = ((299 * rgba[idx]! + 587 * rgba[idx + 1]! + 114 * rgba[idx + 2]! + 500) / 1000) | 0;
+      const value = luma + (current[x + 1]! >> 4);
+      const white = value >= threshold;
+      if (white) {
+        const byte = out + (x >> 3);
+        data[byte] = data[byte]! | (0x80 >> (x & 7));
+      }
+
+      // 7/16 ahead, 3/16 behind below, 5/16 below, 1/16 ahead below
+      const error = value - (white ? 255 : 0);
+      current[x + 1 + step] = current[x + 1 + step]! + error * 7;
+      next[x + 1 - step] = next[x + 1 - step]! + error * 3;
+      next[x + 1] = next[x + 1]! + error * 5;
+      next[x + 1 + step] = next[x + 1 + step]! + error;
+    }
+
+    [current, next] = [next, current];
+    next.fill(0);
+  }
+
+  return data;
+}
+
+/**
+ * Convert RGBA pixels to a packed 1-bit bitmap
+ * @param rgba RGBA pixel data (4 bytes per pixel)
+ * @param threshold Luminance at or above which a pixel is white (0-255);
+ * when dithering it shifts the gray levels darker or lighter (128 = neutral)
+ * @param dither "ordered" (Bayer 8x8) or "floyd-steinberg" draw gray levels and photos as dot patterns
+ */
+export function toMonochrome(
+  rgba: Buffer | Uint8Array,
+  width: number,
+  height: number,
+  threshold: number,
+  dither: DitherMode = "none"
+): MonochromeBitmap {
+  const bytesPerRow = Math.ceil(width / 8);
+
+  let data: Buffer;
+  if (dither === "floyd-steinberg") {
+    data = packDiffused(rgba, width, height, bytesPerRow, threshold);
+  } else {
+    // Ordered: matrix cells spread evenly over the gray levels around the threshold
+    const levels =
+      dither === "ordered"
+        ? Int32Array.from(BAYER_8X8, (cell) => Math.round((((cell + 0.5) * 255) / 64 + threshold - 128) * 1000))
+        : new Int32Array(64).fill(threshold * 1000);
+    data = packThresholded(rgba, width, height, bytesPerRow, levels);
+  }
+
+  return { width, height, bytesPerRow, data };
+}
+
+/**
+ * Wrap a monochrome bitmap in a 1-bit top-down BMP file (62-byte header, 4-byte row padding)
+ */
+export function encodeBmp(bitmap: MonochromeBitmap): Buffer {
+  const { width, height, bytesPerRow } = bitmap;
+
+  // Calculate row size with padding (each row must be multiple of 4 bytes)
+  const paddedBytesPerRow = Math.ceil(bytesPerRow / 4) * 4;
+  const pixelDataSize = paddedBytesPerRow * height;
+
+  // BMP file structure sizes
+  const fileHeaderSize = 14;
+  const infoHeaderSize = 40;
+  const colorTableSize = 8; // 2 colors * 4 bytes each
+  const pixelDataOffset = fileHeaderSize + infoHeaderSize + colorTableSize;
+  const fileSize = pixelDataOffset + pixelDataSize;
+
+  // Create buffer for entire BMP file
+  const bmpBuffer = Buffer.alloc(fileSize);
+  let offset = 0;
+
+  // Write BMP File Header (14 bytes)
+  bmpBuffer.write("BM", offset);
+  offset += 2; // Signature
+  bmpBuffer.writeUInt32LE(fileSize, offset);
+  offset += 4; // File size
+  bmpBuffer.writeUInt32LE(0, offset);
+  offset += 4; // Reserved
+  bmpBuffer.writeUInt32LE(pixelDataOffset, offset);
+  offset += 4; // Pixel data offset
+
+  // Write DIB Header (BITMAPINFOHEADER - 40 bytes)
+  bmpBuffer.writeUInt32LE(infoHeaderSize, offset);
+  offset += 4; // Header size
+  bmpBuffer.writeInt32LE(width, offset);
+  offset += 4; // Width
+  bmpBuffer.writeInt32LE(-height, offset);
+  offset += 4; // Height (negative = top-down)
+  bmpBuffer.writeUInt16LE(1, offset);
+  offset += 2; // Planes
+  bmpBuffer.writeUInt16LE(1, offset);
+  offset += 2; // Bits per pixel (1-bit)
+  bmpBuffer.writeUInt32LE(0, offset);
+  offset += 4; // Compression (none)
+  bmpBuffer.writeUInt32LE(pixelDataSize, offset);
+  offset += 4; // Image size
+  bmpBuffer.writeInt32LE(2835, offset);
+  offset += 4; // X pixels per meter
+  bmpBuffer.writeInt32LE(2835, offset);
+  offset += 4; // Y pixels per meter
+  bmpBuffer.writeUInt32LE(2, offset);
+  offset += 4; // Colors in palette
+  bmpBuffer.writeUInt32LE(0, offset);
+  offset += 4; // Important colors (0 = all)
+
+  // Write Color Palette (2 colors, 4 bytes each: B G R reserved)
+  bmpBuffer.writeUInt8(0, offset++); // Black - Blue
+  bmpBuffer.writeUInt8(0, offset++); // Black - Green
+  bmpBuffer.writeUInt8(0, offset++); // Black - Red
+  bmpBuffer.writeUInt8(0, offset++); // Black - Reserved
+  bmpBuffer.writeUInt8(255, offset++); // White - Blue
+  bmpBuffer.writeUInt8(255, offset++); // White - Green
+  bmpBuffer.writeUInt8(255, offset++); // White - Red
+  bmpBuffer.writeUInt8(0, offset++); // White - Reserved
+
+  // Write pixel data (top-down), padding is already zero from Buffer.alloc
+  for (let y = 0; y < height; y++) {
+    bitmap.data.copy(bmpBuffer, offset + y * paddedBytesPerRow, y * bytesPerRow, (y + 1) * bytesPerRow);
+  }
+
+  return bmpBuffer;
+}
+
+/**
+ * PackBits run-length encoding (as in TIFF/MacPaint)
+ *
+ * Header byte n: 0..127 copies the next n+1 bytes literally,
+ * 129..255 repeats the next byte 257-n times. Runs continue across rows,
+ * so mostly-white frames compress to a few hundred bytes.
+ */
+export function encodePackBits(input: Buffer | Uint8Array): Buffer {
+  const out = Buffer.alloc(input.length + Math.ceil(input.length / 128) + 1);
+  let outPos = 0;
+  let i = 0;
+
+  while (i < input.length) {
+    // Measure the run starting at i
+    let run = 1;
+    while (i + run < input.length && run < 128 && input[i + run] === input[i]) {
+      run++;
+    }
+
+    if (run >= 2) {
+      out[outPos++] = 257 - run;
+      out[outPos++] = input[i]!;
+      i += run;
+      continue;
+    }
+
+    // Literal: extend until a run of 2+ starts or 128 bytes are collected
+    let literalEnd = i + 1;
+    while (
+      literalEnd < input.length &&
+      literalEnd - i < 128 &&
+      !(literalEnd + 1 < input.length && input[literalEnd] === input[literalEnd + 1])
+    ) {
+      literalEnd++;
+    }
+
+    out[outPos++] = literalEnd - i - 1;
+    for (let j = i; j < literalEnd; j++) {
+      out[outPos++] = input[j]!;
+    }
+    i = literalEnd;
+  }
+
+  return out.subarray(0, outPos);
+}
+
+/**
+ * Decode PackBits data (used by tests and tooling)
+ */
+export function decodePackBits(input: Buffer | Uint8Array): Buffer {
+  const chunks: number[] = [];
+  let i = 0;
+
+  while (i < input.length) {
+    const n = input[i++]!;
+
+    if (n < 128) {
+      for (let j = 0; j <= n && i < input.length; j++) {
+        chunks.push(input[i++]!);
+      }
+    } else if (n > 128) {
+      const value = input[i++] ?? 0;
+      for (let j = 0; j < 257 - n; j++) {
+        chunks.push(value);
+      }
+    }
+    // n === 128 is a no-op
+  }
+
+  return Buffer.from(chunks);
+}
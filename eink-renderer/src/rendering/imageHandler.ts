@@ -2,11 +2,17 @@ import http from "http";
 import { URL } from "url";
 import { Jimp } from "jimp";
 import * as renderedCache from "../core/cache/index.js";
+import { imageCache } from "../core/cache/index.js";
+import type { CachedImage } from "../core/cache/imageCache.js";
+import { IMAGE_CACHE_TTL, IMAGE_DITHER } from "../core/constants.js";
+import { computeEtag, etagMatches } from "../core/etag.js";
 import { loadTemplate, templateExists } from "../templates/index.js";
 import { extractEntityIds, extractCalendarIds, renderTemplate } from "../templates/index.js";
 import { getMultipleStates, getCalendarEvents } from "../integrations/homeassistant/index.js";
 import type { CalendarEvent } from "../integrations/homeassistant/index.js";
 import { type BrowserManager } from "./browserManager.js";
+import { DITHER_MODES, encodeBmp, encodePackBits, toMonochrome, type DitherMode } from "./bitmap.js";
+import { decodePng } from "./png.js";
 
 /**
  * Fetch multiple calendars in parallel
@@ -44,7 +50,7 @@ interface ValidationResult {
   error?: { code: number; message: string; details: string };
 }
 
-const VALID_FORMATS = ["png", "jpeg", "webp", "bmp"] as const;
+const VALID_FORMATS = ["png", "jpeg", "webp", "bmp", "rle", "epd1"] as const;
 type ImageFormat = (typeof VALID_FORMATS)[number];
 
 function validateUrlOrTemplate(url: string | undefined, template: string | undefined): ValidationResult {
@@ -129,6 +135,23 @@ function validateThreshold(threshold: string | undefined): ValidationResult & {
   return { valid: true, threshold: thresholdValue };
 }
 
+function validateDither(dither: string | undefined): ValidationResult & { dither?: DitherMode } {
+  const normalizedDither = (dither || IMAGE_DITHER).toLowerCase();
+
+  if (!DITHER_MODES.includes(normalizedDither as DitherMode)) {
+    return {
+      valid: false,
+      error: {
+        code: 400,
+        message: "Invalid dither parameter",
+        details: `Dither must be one of: ${DITHER_MODES.join(", ")}`,
+      },
+    };
+  }
+
+  return { valid: true, dither: normalizedDither as DitherMode };
+}
+
 function sendError(res: http.ServerResponse, error: { code: number; message: string; details: string }): void {
   res.writeHead(error.code, { "Content-Type": "application/json" });
   res.end(
@@ -139,8 +162,125 @@ function sendError(res: http.ServerResponse, error: { code: number; message: str
   );
 }
 
+interface RenderOptions {
+  url?: string;
+  template?: string;
+  width: number;
+  height: number;
+  format: ImageFormat;
+  quality?: number;
+  threshold: number;
+  dither: DitherMode;
+}
+
+/**
+ * Render the page in the browser and encode it in the requested format
+ */
+async function renderImage(browserManager: BrowserManager, options: RenderOptions): Promise<CachedImage> {
+  const { width, height, format, quality, threshold, dither } = options;
+  const browser = await browserManager.getBrowser();
+  const page = await browser.newPage();
+
+  try {
+    await page.setViewport({ width, height });
+
+    // Handle two modes: URL mode or Template mode
+    if (options.template) {
+      // Template mode: fetch rendered HTML from cache or render it
+      const templateName = options.template;
+      const cacheKey = `ha:${templateName}`;
+
+      let html = renderedCache.get(cacheKey);
+
+      if (!html) {
+        // Auto-render: template not in cache, fetch and render now
+        const templateHtml = await loadTemplate(templateName);
+        const entityIds = extractEntityIds(templateHtml);
+        const calendarIds = extractCalendarIds(templateHtml);
+
+        // Fetch entity states and calendar events in parallel
+        const [entities, calendars] = await Promise.all([
+          getMultipleStates(entityIds),
+          calendarIds.length > 0
+            ? getMultipleCalendars(calendarIds)
+            : Promise.resolve({} as Record<string, CalendarEvent[]>),
+        ]);
+
+        html = renderTemplate(templateHtml, entities, calendars);
+
+        // Cache it for future requests
+        renderedCache.set(cacheKey, html, 300, {
+          templateName,
+          entitiesFetched: entityIds.length,
+        });
+      }
+
+      // Use setContent instead of goto
+      await page.setContent(html, { waitUntil: "networkidle2", timeout: 10000 });
+    } else {
+      // URL mode: use existing goto logic
+      await page.goto(options.url!, { waitUntil: "networkidle2", timeout: 10000 });
+    }
+
+    let finalImage: Buffer | Uint8Array;
+
+    if (format === "bmp" || format === "rle" || format === "epd1") {
+      // For 1-bit formats, take PNG screenshot and convert to monochrome
+      // The PNG is decoded right away, so trade compression for a faster capture,
+      // and keep the capture to the viewport so Chrome does not resize its surface
+      const pngScreenshot = await page.screenshot({
+        type: "png",
+        fullPage: false,
+        optimizeForSpeed: true,
+        captureBeyondViewport: false,
+      });
+
+      // Decode straight to RGBA; Jimp covers PNG variants the fast decoder does not
+      const { width, height, data } = decodePng(pngScreenshot) ?? (await Jimp.read(Buffer.from(pngScreenshot))).bitmap;
+      const bitmap = toMonochrome(data, width, height, threshold, dither);
+
+      // epd1: the raw rows in panel RAM layout (top-down, MSB first, 1 = white, no header or padding)
+      // rle: PackBits over those rows, decoded on the fly by the device
+      if (format === "bmp") {
+        finalImage = encodeBmp(bitmap);
+      } else if (format === "rle") {
+        finalImage = encodePackBits(bitmap.data);
+      } else {
+        finalImage = bitmap.data;
+      }
+    } else {
+      // For other formats, use Puppeteer's native support
+      const screenshotOptions: {
+        type: "png" | "jpeg" | "webp";
+        fullPage: boolean;
+        quality?: number;
+      } = {
+        type: format as "png" | "jpeg" | "webp",
+        fullPage: false,
+      };
+
+      if (format !== "png" && quality !== undefined) {
+        screenshotOptions.quality = quality;
+      }
+
+      finalImage = await page.screenshot(screenshotOptions);
+    }
+
+    // The tag covers the complete image, so every offset/limit chunk shares one validator
+    return { data: finalImage, etag: computeEtag(finalImage) };
+  } finally {
+    // Always close the page after use, but keep the browser running
+    await page.close();
+  }
+}
+
 export function createImageRequestHandler(browserManager: BrowserManager) {
-  return async (url: URL, params: Record<string, string>, res: http.ServerResponse) => {
+  return async (
+    url: URL,
+    params: Record<string, string>,
+    res: http.ServerResponse,
+    headers: http.IncomingHttpHeaders = {}
+  ) => {
     // Validate all parameters
     const urlOrTemplateValidation = validateUrlOrTemplate(params.url, params.template);
     if (!urlOrTemplateValidation.valid) {
@@ -166,241 +306,90 @@ export function createImageRequestHandler(browserManager: BrowserManager) {
       return;
     }
 
+    const ditherValidation = validateDither(params.dither);
+    if (!ditherValidation.valid) {
+      sendError(res, ditherValidation.error!);
+      return;
+    }
+
     // Extract validated values
     const format = formatValidation.format!;
     const quality = qualityValidation.quality;
     const threshold = thresholdValidation.threshold!;
+    const dither = ditherValidation.dither!;
+    const width = parseInt(params.width || "800");
+    const height = parseInt(params.height || "480");
+
+    if (params.template && !renderedCache.has(`ha:${params.template}`) && !templateExists(params.template)) {
+      res.writeHead(404, { "Content-Type": "application/json" });
+      res.end(
+        JSON.stringify({
+          error: "Template not found",
+          message: `Template '${params.template}' not found. Call /ha/render first or ensure template file exists.`,
+        })
+      );
+      return;
+    }
 
     try {
-      const browser = await browserManager.getBrowser();
-      const page = await browser.newPage();
-
-      try {
-        const width = parseInt(params.width || "800");
-        const height = parseInt(params.height || "480");
-        await page.setViewport({ width, height });
-
-        // Handle two modes: URL mode or Template mode
-        if (params.template) {
-          // Template mode: fetch rendered HTML from cache or render it
-          const templateName = params.template;
-          const cacheKey = `ha:${templateName}`;
-
-          let html = renderedCache.get(cacheKey);
-
-          if (!html) {
-            // Auto-render: template not in cache, fetch and render now
-            if (!templateExists(templateName)) {
-              res.writeHead(404, { "Content-Type": "application/json" });
-              res.end(
-                JSON.stringify({
-                  error: "Template not found",
-                  message: `Template '${templateName}' not found. Call /ha/render first or ensure template file exists.`,
-                })
-              );
-              return;
-            }
-
-            // Load and render template
-            const templateHtml = await loadTemplate(templateName);
-            const entityIds = extractEntityIds(templateHtml);
-            const calendarIds = extractCalendarIds(templateHtml);
-
-            // Fetch entity states and calendar events in parallel
-            const [entities, calendars] = await Promise.all([
-              getMultipleStates(entityIds),
-              calendarIds.length > 0
-                ? getMultipleCalendars(calendarIds)
-                : Promise.resolve({} as Record<string, CalendarEvent[]>),
-            ]);
-
-            html = renderTemplate(templateHtml, entities, calendars);
-
-            // Cache it for future requests
-            renderedCache.set(cacheKey, html, 300, {
-              templateName,
-              entitiesFetched: entityIds.length,
-            });
-          }
-
-          // Use setContent instead of goto
-          await page.setContent(html, { waitUntil: "networkidle2", timeout: 10000 });
-        } else {
-          // URL mode: use existing goto logic
-          const targetUrl = params.url!;
-          await page.goto(targetUrl, { waitUntil: "networkidle2", timeout: 10000 });
-        }
+      // Chunk requests of one device refresh reuse a single render
+      const source = params.template ? `template:${params.template}` : `url:${params.url}`;
+      const cacheKey = imageCache.buildKey({ source, width, height, threshold, dither, format, quality });
+      const { data: finalImage, etag } = await imageCache.getOrRender(cacheKey, source, IMAGE_CACHE_TTL, () =>
+        renderImage(browserManager, {
+          url: params.url,
+          template: params.template,
+          width,
+          height,
+          format,
+          quality,
+          threshold,
+          dither,
+        })
+      );
 
-        let finalImage: Buffer | Uint8Array;
-
-        if (format === "bmp") {
-          // For BMP, take PNG screenshot and convert to 1-bit monochrome
-          const pngScreenshot = await page.screenshot({
-            type: "png",
-            fullPage: false,
-          });
-
-          // Read PNG and apply monochrome conversion
-          const image = await Jimp.read(Buffer.from(pngScreenshot));
-          const { width, height, data } = image.bitmap;
-
-          // Calculate row size with padding (each row must be multiple of 4 bytes)
-          const bytesPerRow = Math.ceil(width / 8);
-          const paddedBytesPerRow = Math.ceil(bytesPerRow / 4) * 4;
-          const pixelDataSize = paddedBytesPerRow * height;
-
-          // BMP file structure sizes
-          const fileHeaderSize = 14;
-          const infoHeaderSize = 40;
-          const colorTableSize = 8; // 2 colors * 4 bytes each
-          const pixelDataOffset = fileHeaderSize + infoHeaderSize + colorTableSize;
-          const fileSize = pixelDataOffset + pixelDataSize;
-
-          // Create buffer for entire BMP file
-          const bmpBuffer = Buffer.alloc(fileSize);
-          let offset = 0;
-
-          // Write BMP File Header (14 bytes)
-          bmpBuffer.write("BM", offset);
-          offset += 2; // Signature
-          bmpBuffer.writeUInt32LE(fileSize, offset);
-          offset += 4; // File size
-          bmpBuffer.writeUInt32LE(0, offset);
-          offset += 4; // Reserved
-          bmpBuffer.writeUInt32LE(pixelDataOffset, offset);
-          offset += 4; // Pixel data offset
-
-          // Write DIB Header (BITMAPINFOHEADER - 40 bytes)
-          bmpBuffer.writeUInt32LE(infoHeaderSize, offset);
-          offset += 4; // Header size
-          bmpBuffer.writeInt32LE(width, offset);
-          offset += 4; // Width
-          bmpBuffer.writeInt32LE(-height, offset);
-          offset += 4; // Height (negative = top-down)
-          bmpBuffer.writeUInt16LE(1, offset);
-          offset += 2; // Planes
-          bmpBuffer.writeUInt16LE(1, offset);
-          offset += 2; // Bits per pixel (1-bit)
-          bmpBuffer.writeUInt32LE(0, offset);
-          offset += 4; // Compression (none)
-          bmpBuffer.writeUInt32LE(pixelDataSize, offset);
-          offset += 4; // Image size
-          bmpBuffer.writeInt32LE(2835, offset);
-          offset += 4; // X pixels per meter
-          bmpBuffer.writeInt32LE(2835, offset);
-          offset += 4; // Y pixels per meter
-          bmpBuffer.writeUInt32LE(2, offset);
-          offset += 4; // Colors in palette
-          bmpBuffer.writeUInt32LE(0, offset);
-          offset += 4; // Important colors (0 = all)
-
-          // Write Color Palette (2 colors, 4 bytes each: B G R reserved)
-          bmpBuffer.writeUInt8(0, offset++); // Black - Blue
-          bmpBuffer.writeUInt8(0, offset++); // Black - Green
-          bmpBuffer.writeUInt8(0, offset++); // Black - Red
-          bmpBuffer.writeUInt8(0, offset++); // Black - Reserved
-          bmpBuffer.writeUInt8(255, offset++); // White - Blue
-          bmpBuffer.writeUInt8(255, offset++); // White - Green
-          bmpBuffer.writeUInt8(255, offset++); // White - Red
-          bmpBuffer.writeUInt8(0, offset++); // White - Reserved
-
-          // Write pixel data (top-down, left-to-right)
-          for (let y = 0; y < height; y++) {
-            let bitIndex = 0;
-            let currentByte = 0;
-
-            for (let x = 0; x < width; x++) {
-              const idx = (y * width + x) * 4;
-              const r = data[idx] ?? 0;
-              const g = data[idx + 1] ?? 0;
-              const b = data[idx + 2] ?? 0;
-
-              // Calculate luminance
-              const luminance = 0.299 * r + 0.587 * g + 0.114 * b;
-
-              // Apply threshold: 1 = white, 0 = black (for palette index)
-              const bit = luminance >= threshold ? 1 : 0;
-
-              // Pack bit into byte (MSB first)
-              currentByte = (currentByte << 1) | bit;
-              bitIndex++;
-
-              // Write byte when we have 8 bits or at end of row
-              if (bitIndex === 8) {
-                bmpBuffer.writeUInt8(currentByte, offset++);
-                currentByte = 0;
-                bitIndex = 0;
-              }
-            }
-
-            // Write remaining bits if row width is not multiple of 8
-            if (bitIndex > 0) {
-              currentByte <<= 8 - bitIndex; // Pad with zeros
-              bmpBuffer.writeUInt8(currentByte, offset++);
-            }
-
-            // Add padding to make row size multiple of 4 bytes
-            const padding = paddedBytesPerRow - bytesPerRow;
-            for (let p = 0; p < padding; p++) {
-              bmpBuffer.writeUInt8(0, offset++);
-            }
-          }
-
-          finalImage = bmpBuffer;
-        } else {
-          // For other formats, use Puppeteer's native support
-          const screenshotOptions: {
-            type: "png" | "jpeg" | "webp";
-            fullPage: boolean;
-            quality?: number;
-          } = {
-            type: format as "png" | "jpeg" | "webp",
-            fullPage: false,
-          };
-
-          if (format !== "png" && quality !== undefined) {
-            screenshotOptions.quality = quality;
-          }
-
-          finalImage = await page.screenshot(screenshotOptions);
-        }
+      // Devices send back the last ETag they displayed; skip the transfer if the frame is unchanged
+      if (etagMatches(headers["if-none-match"], etag)) {
+        res.writeHead(304, { ETag: etag });
+        res.end();
+        return;
+      }
 
-        // Handle chunking if offset/limit parameters are provided
-        const offset = parseInt(params.offset || "0");
-        const limit = params.limit ? parseInt(params.limit) : undefined;
-        const includeHeader = params.includeHeader === "true";
+      // Handle chunking if offset/limit parameters are provided
+      const offset = parseInt(params.offset || "0");
+      const limit = params.limit ? parseInt(params.limit) : undefined;
+      const includeHeader = params.includeHeader === "true";
 
-        let imageChunk: Buffer | Uint8Array = finalImage;
+      let imageChunk: Buffer | Uint8Array = finalImage;
 
-        if (offset > 0 || limit !== undefined) {
-          const start = offset;
-          const end = limit !== undefined ? Math.min(offset + limit, finalImage.length) : finalImage.length;
-          imageChunk = finalImage.slice(start, end);
+      if (offset > 0 || limit !== undefined) {
+        const start = offset;
+        const end = limit !== undefined ? Math.min(offset + limit, finalImage.length) : finalImage.length;
+        imageChunk = finalImage.subarray(start, end);
 
-          // If includeHeader is true and we're using an offset, prepend the header bytes
-          // This allows the image to be viewable in a browser even with offset-based downloads
-          if (includeHeader && offset > 0) {
-            const header = finalImage.slice(0, offset);
-            imageChunk = Buffer.concat([header, imageChunk]);
-          }
+        // If includeHeader is true and we're using an offset, prepend the header bytes
+        // This allows the image to be viewable in a browser even with offset-based downloads
+        if (includeHeader && offset > 0) {
+          const header = finalImage.subarray(0, offset);
+          imageChunk = Buffer.concat([header, imageChunk]);
         }
-
-        const contentTypeMap: Record<string, string> = {
-          png: "image/png",
-          jpeg: "image/jpeg",
-          webp: "image/webp",
-          bmp: "image/bmp",
-        };
-
-        res.writeHead(200, {
-          "Content-Type": contentTypeMap[format],
-          "Content-Length": imageChunk.length.toString(),
-        });
-        res.end(imageChunk);
-      } finally {
-        // Always close the page after use, but keep the browser running
-        await page.close();
       }
+
+      const contentTypeMap: Record<string, string> = {
+        png: "image/png",
+        jpeg: "image/jpeg",
+        webp: "image/webp",
+        bmp: "image/bmp",
+        rle: "application/octet-stream",
+        epd1: "application/octet-stream",
+      };
+
+      res.writeHead(200, {
+        "Content-Type": contentTypeMap[format],
+        "Content-Length": imageChunk.length.toString(),
+        ETag: etag,
+      });
+      res.end(imageChunk);
     } catch (error) {
       res.writeHead(500, { "Content-Type": "application/json" });
       res.end(
@@ -0,0 +1,156 @@
+/**
+ * PNG decoder for browser screenshots
+ *
+ * Inflates with node's zlib and undoes the row filters in place, without
+ * the image object and per-pixel callbacks of a general decoder. Handles
+ * what Chrome writes (8-bit RGB or RGBA, not interlaced); anything else
+ * returns null so callers can fall back to Jimp.
+ */
+
+import { inflateSync } from "node:zlib";
+
+/** Decoded pixels, 4 bytes per pixel */
+export interface RgbaImage {
+  width: number;
+  height: number;
+  data: Uint8Array;
+}
+
+const SIGNATURE = Buffer.from([0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a]);
+
+const COLOR_RGB = 2;
+const COLOR_RGBA = 6;
+
+/**
+ * Reverse the filter of one row in place
+ * @param prior Previous row after unfiltering (zeros for the first row)
+ * @param bpp Bytes per pixel
+ */
+function unfilterRow(filter: number, row: Uint8Array, prior: Uint8Array, bpp: number): boolean {
+  const length = row.length;
+  switch (filter) {
+    case 0:
+      return true;
+    case 1:
+      for (let i = bpp; i < length; i++) {
+        row[i] = row[i]! + row[i - bpp]!;
+      }
+      return true;
+    case 2:
+      for (let i = 0; i < length; i++) {
+        row[i] = row[i]! + prior[i]!;
+      }
+      return true;
+    case 3:
+      for (let i = 0; i < bpp; i++) {
+        row[i] = row[i]! + (prior[i]! >> 1);
+      }
+      for (let i = bpp; i < length; i++) {
+        row[i] = row[i]! + ((row[i - bpp]! + prior[i]!) >> 1);
+      }
+      return true;
+    case 4:
+      for (let i = 0; i < bpp; i++) {
+        row[i] = row[i]! + prior[i]!;
+      }
+      for (let i = bpp; i < length; i++) {
+        const left = row[i - bpp]!;
+        const up = prior[i]!;
+        const upLeft = prior[i - bpp]!;
+        // Distances of left + up - upLeft to each neighbour
+        let pa = up - upLeft;
+        let pb = left - upLeft;
+        let pc = pa + pb;
+        pa = pa < 0 ? -pa : pa;
+        pb = pb < 0 ? -pb : pb;
+        pc = pc < 0 ? -pc : pc;
+        row[i] = row[i]! + (pa <= pb && pa <= pc ? left : pb <= pc ? up : upLeft);
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Decode a PNG into RGBA pixels
+ * @returns null for PNGs outside what this decoder handles (palette, gray,
+ * 16-bit, interlaced) or that are malformed
+ */
+export function decodePng(png: Buffer | Uint8Array): RgbaImage | null {
+  const file = Buffer.from(png.buffer, png.byteOffset, png.byteLength);
+  if (file.length < 8 || !file.subarray(0, 8).equals(SIGNATURE)) {
+    return null;
+  }
+
+  let width = 0;
+  let height = 0;
+  let bpp = 0;
+  const chunks: Buffer[] = [];
+
+  for (let offset = 8; offset + 8 <= file.length; ) {
+    const length = file.readUInt32BE(offset);
+    const type = file.toString("latin1", offset + 4, offset + 8);
+    const body = file.subarray(offset + 8, offset + 8 + length);
+
+    if (type === "IHDR") {
+      // 8 bits per channel, not interlaced
+      const colorType = body[9];
+      const plain = body.length >= 13 && body[8] === 8 && body[12] === 0;
+      if (!plain || (colorType !== COLOR_RGB && colorType !== COLOR_RGBA)) {
+        return null;
+      }
+      width = body.readUInt32BE(0);
+      height = body.readUInt32BE(4);
+      bpp = colorType === COLOR_RGBA ? 4 : 3;
+    } else if (type === "IDAT") {
+      chunks.push(body);
+    } else if (type === "IEND") {
+      break;
+    }
+    offset += 12 + length;
+  }
+
+  if (bpp === 0 || chunks.length === 0) {
+    return null;
+  }
+
+  let raw: Buffer;
+  try {
+    raw = inflateSync(chunks.length === 1 ? chunks[0]! : Buffer.concat(chunks));
+  } catch {
+    return null;
+  }
+
+  // Each row is a filter byte followed by the filtered pixels
+  const stride = width * bpp;
+  if (raw.length < (stride + 1) * height) {
+    return null;
+  }
+
+  const data = new Uint8Array(width * height * 4);
+  let prior: Uint8Array = new Uint8Array(stride);
+
+  for (let y = 0; y < height; y++) {
+    const start = y * (stride + 1);
+    const row = raw.subarray(start + 1, start + 1 + stride);
+    if (!unfilterRow(raw[start]!, row, prior, bpp)) {
+      return null;
+    }
+
+    const out = y * width * 4;
+    if (bpp === 4) {
+      data.set(row, out);
+    } else {
+      for (let x = 0, i = 0, o = out; x < width; x++, i += 3, o += 4) {
+        data[o] = row[i]!;
+        data[o + 1] = row[i + 1]!;
+        data[o + 2] = row[i + 2]!;
+        data[o + 3] = 255;
+      }
+    }
+    prior = row;
+  }
+
+  return { width, height, data };
+}
@@ -2,6 +2,7 @@ import { describe, it, expect, beforeAll, afterAll } from "vitest";
 import { createServer } from "../index.js";
 import http from "http";
 import type { BrowserManager } from "../../rendering/index.js";
+import { decodePackBits } from "../../rendering/bitmap.js";
 
 const TEST_PORT = 3001;
 let server: http.Server;
@@ -46,10 +47,36 @@ function makeRequest(
   });
 }
 
+function postJson(path: string, body: string): Promise<{ statusCode: number; data: string }> {
+  return new Promise((resolve, reject) => {
+    const req = http.request(
+      {
+        hostname: "localhost",
+        port: TEST_PORT,
+        path,
+        method: "POST",
+        headers: { "Content-Type": "application/json", "Content-Length": Buffer.byteLength(body) },
+      },
+      (res) => {
+        let data = "";
+        res.on("data", (chunk) => {
+          data += chunk;
+        });
+        res.on("end", () => {
+          resolve({ statusCode: res.statusCode || 0, data });
+        });
+      }
+    );
+    req.on("error", reject);
+    req.end(body);
+  });
+}
+
 function makeRequestBinary(
   path: string,
-  method: string = "GET"
-): Promise<{ statusCode: number; data: Buffer; contentType: string; contentLength: string }> {
+  method: string = "GET",
+  headers: http.OutgoingHttpHeaders = {}
+): Promise<{ statusCode: number; data: Buffer; contentType: string; contentLength: string; etag: string }> {
   return new Promise((resolve, reject) => {
     const req = http.request(
       {
@@ -57,6 +84,7 @@ function makeRequestBinary(
         port: TEST_PORT,
         path,
         method,
+        headers,
       },
       (res) => {
         const chunks: Buffer[] = [];
@@ -69,6 +97,7 @@ function makeRequestBinary(
             data: Buffer.concat(chunks),
             contentType: res.headers["content-type"] || "",
             contentLength: res.headers["content-length"] || "",
+            etag: res.headers["etag"] || "",
           });
         });
       }
@@ -158,12 +187,17 @@ describe("HTTP Server", () => {
     expect(json.image).toHaveProperty("base_url");
     expect(json.image).toHaveProperty("parameters");
     expect(json.image.parameters).toHaveProperty("format", "bmp");
+    expect(json.image).toHaveProperty("stream", true);
     expect(json).toHaveProperty("display");
     expect(json.display).toEqual({
       width: 800,
       height: 480,
       refresh_interval_sec: 300,
     });
+    expect(json.changes).toEqual({ path: "/changes", timeout_sec: 50 });
+    // No layout file in the test environment
+    expect(json.regions).toBeUndefined();
+    expect(json.overlays).toBeUndefined();
   });
 
   it("should handle /config with query parameters", async () => {
@@ -175,6 +209,96 @@ describe("HTTP Server", () => {
     expect(json.image.path).toBe("/image");
   });
 
+  it("should answer a device's capabilities with its own policy", async () => {
+    const response = await makeRequest(
+      "/config?panel=GxEPD2_583_T8&width=648&height=480&heap=182000&psram=0&formats=epd1,rle,bmp&partial=1&sleep=1&fw=1.1.0"
+    );
+    expect(response.statusCode).toBe(200);
+
+    const json = JSON.parse(response.data);
+    expect(json.image.parameters.format).toBe("rle");
+    expect(json.image.stream).toBe(true);
+    expect(json.display).toEqual({
+      width: 648,
+      height: 480,
+      refresh_interval_sec: 300,
+      partial_refresh_cycles: 10,
+      full_refresh_minutes: 60,
+    });
+    // A deep sleeping device never long-polls
+    expect(json.changes).toBeUndefined();
+  });
+
+  it("should keep the scheme the device used in base_url", async () => {
+    const plain = JSON.parse((await makeRequest("/config")).data);
+    expect(plain.image.base_url).toBe(`http://localhost:${TEST_PORT}`);
+
+    const proxied = await makeRequestBinary("/config", "GET", { "X-Forwarded-Proto": "https" });
+    expect(JSON.parse(proxied.data.toString()).image.base_url).toBe(`https://localhost:${TEST_PORT}`);
+  });
+
+  it("should revalidate /config with its ETag", async () => {
+    const first = await makeRequestBinary("/config");
+    expect(first.statusCode).toBe(200);
+    expect(first.etag).toMatch(/^"[0-9a-f]{16}"$/);
+    expect(first.contentLength).toBe(String(first.data.length));
+
+    const second = await makeRequestBinary("/config", "GET", { "If-None-Match": first.etag });
+    expect(second.statusCode).toBe(304);
+    expect(second.etag).toBe(first.etag);
+    expect(second.data.length).toBe(0);
+  });
+
+  describe("Changes", () => {
+    it("should reject an out-of-range timeout", async () => {
+      const response = await makeRequest("/changes?timeout=3600");
+      expect(response.statusCode).toBe(400);
+    });
+
+    it("should return 404 for an unknown template", async () => {
+      const response = await makeRequest("/changes?template=does-not-exist.html&timeout=0");
+      expect(response.statusCode).toBe(404);
+    });
+  });
+
+  describe("Telemetry", () => {
+    it("should accept a device report and aggregate it", async () => {
+      const report = {
+        device: "test-device",
+        cycle: 3,
+        ms: { wifi: 320, config: 45, ttfb: 900, download: 500, write: 80, refresh: 3900, total: 5800 },
+        requests: 2,
+        bytes: 48000,
+        rssi: -58,
+        heap: { free: 150000, largest: 110000, min: 120000 },
+      };
+
+      const post = await postJson("/telemetry", JSON.stringify(report));
+      expect(post.statusCode).toBe(204);
+
+      const response = await makeRequest("/telemetry?device=test-device");
+      expect(response.statusCode).toBe(200);
+
+      const json = JSON.parse(response.data);
+      expect(json.reports).toBeGreaterThanOrEqual(1);
+      expect(json.last.rssi).toBe(-58);
+      expect(json.phases.refresh.max).toBeGreaterThanOrEqual(3900);
+    });
+
+    it("should reject malformed reports", async () => {
+      const invalidJson = await postJson("/telemetry", "{not json");
+      expect(invalidJson.statusCode).toBe(400);
+
+      const missingFields = await postJson("/telemetry", JSON.stringify({ cycle: 1 }));
+      expect(missingFields.statusCode).toBe(400);
+    });
+
+    it("should return 404 for an unknown device", async () => {
+      const response = await makeRequest("/telemetry?device=never-seen");
+      expect(response.statusCode).toBe(404);
+    });
+  });
+
   it("should return 400 when /image is called without url parameter", async () => {
     const response = await makeRequest("/image");
     expect(response.statusCode).toBe(400);
@@ -311,6 +435,102 @@ describe("HTTP Server", () => {
     30000
   );
 
+  describe("ETag", () => {
+    it(
+      "should return the same ETag for every chunk of one image",
+      async () => {
+        const testUrl = "data:text/html,<h1>ETag Test</h1>";
+        const first = await makeRequestBinary(
+          `/image?url=${encodeURIComponent(testUrl)}&format=bmp&offset=62&limit=1000`
+        );
+        const second = await makeRequestBinary(
+          `/image?url=${encodeURIComponent(testUrl)}&format=bmp&offset=1062&limit=1000`
+        );
+
+        expect(first.statusCode).toBe(200);
+        expect(first.etag).toMatch(/^"[0-9a-f]{16}"$/);
+        expect(second.etag).toBe(first.etag);
+      },
+      30000
+    );
+
+    it(
+      "should return 304 with no body when If-None-Match matches",
+      async () => {
+        const testUrl = "data:text/html,<h1>Not Modified</h1>";
+        const path = `/image?url=${encodeURIComponent(testUrl)}&format=bmp&offset=62&limit=48000`;
+        const first = await makeRequestBinary(path);
+
+        const second = await makeRequestBinary(path, "GET", { "If-None-Match": first.etag });
+
+        expect(second.statusCode).toBe(304);
+        expect(second.etag).toBe(first.etag);
+        expect(second.data.length).toBe(0);
+      },
+      30000
+    );
+
+    it(
+      "should return the full response when If-None-Match is stale",
+      async () => {
+        const testUrl = "data:text/html,<h1>Changed</h1>";
+        const response = await makeRequestBinary(
+          `/image?url=${encodeURIComponent(testUrl)}&format=bmp`,
+          "GET",
+          { "If-None-Match": '"0000000000000000"' }
+        );
+
+        expect(response.statusCode).toBe(200);
+        expect(response.data.toString("ascii", 0, 2)).toBe("BM");
+      },
+      30000
+    );
+  });
+
+  it(
+    "should support PackBits-compressed rle format matching BMP pixel data",
+    async () => {
+      const testUrl = "data:text/html,<h1>RLE Test</h1>";
+      const bmpResponse = await makeRequestBinary(
+        `/image?url=${encodeURIComponent(testUrl)}&format=bmp`
+      );
+      const rleResponse = await makeRequestBinary(
+        `/image?url=${encodeURIComponent(testUrl)}&format=rle`
+      );
+
+      expect(rleResponse.statusCode).toBe(200);
+      expect(rleResponse.contentType).toBe("application/octet-stream");
+      expect(rleResponse.data.length).toBeLessThan(bmpResponse.data.length / 10);
+
+      // 800px rows are already 4-byte aligned, so BMP pixel data equals the raw rows
+      expect(decodePackBits(rleResponse.data)).toEqual(bmpResponse.data.subarray(62));
+    },
+    30000
+  );
+
+  it(
+    "should support epd1 format as headerless BMP pixel data with chunking",
+    async () => {
+      const testUrl = "data:text/html,<h1>EPD1 Test</h1>";
+      const bmpResponse = await makeRequestBinary(
+        `/image?url=${encodeURIComponent(testUrl)}&format=bmp`
+      );
+      const epdResponse = await makeRequestBinary(
+        `/image?url=${encodeURIComponent(testUrl)}&format=epd1`
+      );
+      const chunkResponse = await makeRequestBinary(
+        `/image?url=${encodeURIComponent(testUrl)}&format=epd1&offset=16000&limit=16000`
+      );
+
+      expect(epdResponse.statusCode).toBe(200);
+      expect(epdResponse.contentType).toBe("application/octet-stream");
+      expect(epdResponse.data.length).toBe(48000);
+      expect(epdResponse.data).toEqual(bmpResponse.data.subarray(62));
+      expect(chunkResponse.data).toEqual(epdResponse.data.subarray(16000, 32000));
+    },
+    30000
+  );
+
   describe("BMP Chunking", () => {
     it(
       "should return full BMP image without offset/limit parameters",
@@ -1,45 +1,107 @@
 import http from "http";
+import type { TLSSocket } from "tls";
 import { URL } from "url";
 
 import { createBrowserManager, createImageRequestHandler } from "../rendering/index.js";
-import { ACTIVE_TEMPLATE_ID } from "../core/constants.js";
+import { ACTIVE_TEMPLATE_ID, PUBLIC_URL } from "../core/constants.js";
+import { computeEtag, etagMatches } from "../core/etag.js";
 import { handleRender, handleEntities } from "../integrations/homeassistant/index.js";
+import { handleTelemetryReport, handleTelemetryQuery } from "../telemetry/index.js";
+import { handleChanges } from "../changes/index.js";
+import { getLayout } from "../config/layout.js";
+import { parseCapabilities, choosePolicy } from "../config/device.js";
+
+/**
+ * Base URL devices reach the server at, keeping the scheme the request came in on
+ * so a device that fetched /config over HTTPS is not moved to plain HTTP
+ */
+function publicBaseUrl(req: http.IncomingMessage): string {
+  if (PUBLIC_URL) {
+    return PUBLIC_URL;
+  }
+  // Behind a TLS-terminating proxy the first hop's scheme is in X-Forwarded-Proto
+  const forwarded = String(req.headers["x-forwarded-proto"] ?? "").split(",")[0]!.trim().toLowerCase();
+  const encrypted = (req.socket as TLSSocket).encrypted === true;
+  const scheme = forwarded === "https" || forwarded === "http" ? forwarded : encrypted ? "https" : "http";
+  return `${scheme}://${req.headers.host}`;
+}
 
 export function createServer() {
   const browserManager = createBrowserManager();
   const handleImageRequest = createImageRequestHandler(browserManager);
 
   const server = http.createServer((req, res) => {
-    if (req.method === "GET" && req.url) {
+    if (req.method === "POST" && req.url && new URL(req.url, `http://${req.headers.host}`).pathname === "/telemetry") {
+      handleTelemetryReport(req, res);
+    } else if (req.method === "GET" && req.url) {
       const url = new URL(req.url, `http://${req.headers.host}`);
       const params = Object.fromEntries(url.searchParams.entries());
 
       if (url.pathname === "/config") {
-        res.writeHead(200, { "Content-Type": "application/json" });
-        res.end(
-          JSON.stringify({
-            image: {
-              path: "/image",
-              parameters: {
-                format: "bmp",
-                quality: 80,
-                threshold: 128,
-                template: ACTIVE_TEMPLATE_ID,
-                offset: 0,
-                limit: undefined,
-                includeHeader: false,
-              },
-              base_url: `http://${req.headers.host}`,
-            },
-            display: {
-              width: 800,
-              height: 480,
-              refresh_interval_sec: 300,
+        // Devices send their capabilities in the query, see config/device.ts
+        const capabilities = parseCapabilities(params);
+        const policy = choosePolicy(capabilities);
+        if (capabilities) {
+          console.info(
+            `Config for ${capabilities.panel || "unknown panel"} ${capabilities.width}x${capabilities.height} ` +
+              `(fw ${capabilities.firmware || "?"}, heap ${capabilities.freeHeap}, psram ${capabilities.psram}): ` +
+              `${policy.format}, ${policy.width}x${policy.height}`
+          );
+        }
+
+        // Regions refreshed on their own interval and text drawn by the device, see config/layout.ts
+        const { regions, overlays, time } = getLayout();
+        const awake = policy.stayAwakeFeatures;
+        const body = JSON.stringify({
+          image: {
+            path: "/image",
+            parameters: {
+              format: policy.format,
+              quality: 80,
+              threshold: 128,
+              template: ACTIVE_TEMPLATE_ID,
+              offset: 0,
+              limit: undefined,
+              includeHeader: false,
             },
-          })
-        );
+            base_url: publicBaseUrl(req),
+            stream: policy.stream,
+          },
+          display: {
+            width: policy.width,
+            height: policy.height,
+            refresh_interval_sec: policy.refreshIntervalSec,
+            partial_refresh_cycles: policy.partialRefreshCycles,
+            full_refresh_minutes: policy.fullRefreshMinutes,
+          },
+          ...(awake
+            ? {
+                changes: {
+                  path: "/changes",
+                  timeout_sec: 50,
+                },
+              }
+            : {}),
+          ...(awake && regions.length > 0 ? { regions } : {}),
+          ...(awake && overlays.length > 0 ? { overlays, time } : {}),
+        });
+
+        // Devices cache the config and revalidate it; Content-Length lets them parse the raw stream
+        const etag = computeEtag(body);
+        if (etagMatches(req.headers["if-none-match"], etag)) {
+          res.writeHead(304, { ETag: etag });
+          res.end();
+          return;
+        }
+
+        res.writeHead(200, {
+          "Content-Type": "application/json",
+          "Content-Length": Buffer.byteLength(body),
+          ETag: etag,
+        });
+        res.end(body);
       } else if (url.pathname === "/image") {
-        handleImageRequest(url, params, res).catch((error: unknown) => {
+        handleImageRequest(url, params, res, req.headers).catch((error: unknown) => {
           console.error("Unhandled error in image handler:", error);
           if (!res.headersSent) {
             res.writeHead(500, { "Content-Type": "application/json" });
@@ -51,6 +113,21 @@ export function createServer() {
             );
           }
         });
+      } else if (url.pathname === "/telemetry") {
+        handleTelemetryQuery(params, res);
+      } else if (url.pathname === "/changes") {
+        handleChanges(req, res, params).catch((error: unknown) => {
+          console.error("Unhandled error in /changes handler:", error);
+          if (!res.headersSent) {
+            res.writeHead(500, { "Content-Type": "application/json" });
+            res.end(
+              JSON.stringify({
+                error: "Internal server error",
+                message: error instanceof Error ? error.message : String(error),
+              })
+            );
+          }
+        });
       } else if (url.pathname === "/ha/render") {
         handleRender(req, res).catch((error: unknown) => {
           console.error("Unhandled error in /ha/render handler:", error);
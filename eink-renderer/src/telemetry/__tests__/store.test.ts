@@ -0,0 +1,87 @@
+import { describe, it, expect, beforeEach } from "vitest";
+import { parseReport, record, getDevice, getAll, clear, setMaxDevices } from "../index.js";
+import type { TelemetryReport } from "../index.js";
+
+function makeReport(device: string, overrides: Partial<TelemetryReport> = {}): TelemetryReport {
+  return {
+    device,
+    cycle: 1,
+    ms: { wifi: 300, config: 40, ttfb: 900, download: 500, write: 80, refresh: 3800, total: 5600 },
+    requests: 2,
+    bytes: 48000,
+    rssi: -60,
+    heap: { free: 150000, largest: 110000, min: 120000 },
+    ...overrides,
+  };
+}
+
+describe("telemetry store", () => {
+  beforeEach(() => {
+    clear();
+    setMaxDevices(100);
+  });
+
+  describe("parseReport", () => {
+    it("should accept a complete report", () => {
+      const report = makeReport("aa:bb");
+      expect(parseReport(JSON.parse(JSON.stringify(report)))).toEqual(report);
+    });
+
+    it("should reject reports without a device or heap", () => {
+      expect(parseReport(null)).toBeNull();
+      expect(parseReport({ ms: {}, heap: {} })).toBeNull();
+      expect(parseReport({ device: "aa", ms: {} })).toBeNull();
+    });
+
+    it("should keep the device log when one is attached", () => {
+      const report = parseReport({ device: "aa", ms: {}, heap: {}, log: "Config unchanged\nRetry 1/3 in 500 ms\n" });
+      expect(report?.log).toBe("Config unchanged\nRetry 1/3 in 500 ms\n");
+      expect(parseReport({ device: "aa", ms: {}, heap: {}, log: 42 })).not.toHaveProperty("log");
+    });
+
+    it("should drop unknown and negative phases", () => {
+      const report = parseReport({ device: "aa", ms: { wifi: 10, bogus: 5, config: -1 }, heap: {} });
+      expect(report?.ms).toEqual({ wifi: 10 });
+    });
+  });
+
+  describe("record", () => {
+    it("should aggregate phases per device", () => {
+      record(makeReport("aa", { ms: { wifi: 100 } }));
+      record(makeReport("aa", { ms: { wifi: 300 } }));
+      record(makeReport("bb", { ms: { wifi: 1000 } }));
+
+      const summary = getDevice("aa");
+      expect(summary?.reports).toBe(2);
+      expect(summary?.phases.wifi).toEqual({ count: 2, min: 100, max: 300, avg: 200 });
+      expect(getDevice("bb")?.phases.wifi?.max).toBe(1000);
+    });
+
+    it("should track the lowest heap ever reported", () => {
+      record(makeReport("aa", { heap: { free: 1, largest: 1, min: 90000 } }));
+      record(makeReport("aa", { heap: { free: 1, largest: 1, min: 120000 } }));
+
+      expect(getDevice("aa")?.minHeapEver).toBe(90000);
+    });
+
+    it("should compute throughput from the last report", () => {
+      record(makeReport("aa", { bytes: 48000, ms: { download: 500 } }));
+
+      expect(getDevice("aa")?.throughput).toBe(96000);
+    });
+
+    it("should evict the least recently seen device when full", () => {
+      setMaxDevices(2);
+      record(makeReport("aa"));
+      record(makeReport("bb"));
+      record(makeReport("cc"));
+
+      expect(getAll()).toHaveLength(2);
+      expect(getDevice("cc")).not.toBeNull();
+    });
+
+    it("should return null for unknown devices", () => {
+      expect(getDevice("missing")).toBeNull();
+    });
+  });
+});
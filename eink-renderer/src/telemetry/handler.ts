@@ -0,0 +1,75 @@
+import { IncomingMessage, ServerResponse } from "node:http";
+import { parseReport, record, getAll, getDevice } from "./store.js";
+
+/**
+ * Reports are a few hundred bytes, up to about 4 KB with attached log lines;
+ * the firmware checks its largest report against this (TELEMETRY_MAX_BODY)
+ */
+const MAX_BODY_BYTES = 4096;
+
+function sendJson(res: ServerResponse, statusCode: number, body: unknown): void {
+  res.writeHead(statusCode, { "Content-Type": "application/json" });
+  res.end(JSON.stringify(body));
+}
+
+/**
+ * Handle POST /telemetry: store one device report
+ */
+export function handleTelemetryReport(req: IncomingMessage, res: ServerResponse): void {
+  const chunks: Buffer[] = [];
+  let size = 0;
+  let rejected = false;
+
+  req.on("data", (chunk: Buffer) => {
+    size += chunk.length;
+    if (size > MAX_BODY_BYTES) {
+      if (!rejected) {
+        rejected = true;
+        sendJson(res, 413, { error: "Payload too large" });
+      }
+      return;
+    }
+    chunks.push(chunk);
+  });
+
+  req.on("end", () => {
+    if (rejected) {
+      return;
+    }
+
+    let body: unknown;
+    try {
+      body = JSON.parse(Buffer.concat(chunks).toString("utf8"));
+    } catch {
+      sendJson(res, 400, { error: "Invalid JSON" });
+      return;
+    }
+
+    const report = parseReport(body);
+    if (!report) {
+      sendJson(res, 400, { error: "Invalid telemetry report" });
+      return;
+    }
+
+    record(report);
+    res.writeHead(204);
+    res.end();
+  });
+}
+
+/**
+ * Handle GET /telemetry: aggregated reports, optionally for one device (?device=)
+ */
+export function handleTelemetryQuery(params: Record<string, string>, res: ServerResponse): void {
+  if (params.device) {
+    const summary = getDevice(params.device);
+    if (!summary) {
+      sendJson(res, 404, { error: "Unknown device", device: params.device });
+      return;
+    }
+    sendJson(res, 200, summary);
+    return;
+  }
+
+  sendJson(res, 200, { devices: getAll() });
+}
@@ -0,0 +1,7 @@
+/**
+ * Device telemetry module barrel export
+ */
+
+export { parseReport, record, getDevice, getAll, clear, setMaxDevices, PHASES } from "./store.js";
+export type { TelemetryReport, DeviceSummary, PhaseStats, Phase } from "./store.js";
+export { handleTelemetryReport, handleTelemetryQuery } from "./handler.js";
@@ -0,0 +1,223 @@
+/**
+ * Per-device aggregation of device telemetry reports
+ */
+
+/** Phases a device times during one refresh cycle (milliseconds) */
+export const PHASES = ["wifi", "config", "ttfb", "download", "write", "refresh", "total"] as const;
+export type Phase = (typeof PHASES)[number];
+
+/** One refresh cycle as reported by a device */
+export interface TelemetryReport {
+  device: string;
+  cycle: number;
+  ms: Partial<Record<Phase, number>>;
+  requests: number;
+  bytes: number;
+  rssi: number;
+  heap: { free: number; largest: number; min: number };
+  /** Log lines since the previous report (debug firmware with LOG_TELEMETRY_BYTES) */
+  log?: string;
+}
+
+export interface PhaseStats {
+  count: number;
+  min: number;
+  max: number;
+  avg: number;
+}
+
+interface PhaseTotals {
+  count: number;
+  min: number;
+  max: number;
+  sum: number;
+}
+
+interface DeviceEntry {
+  reports: number;
+  firstSeen: Date;
+  lastSeen: Date;
+  last: TelemetryReport;
+  phases: Partial<Record<Phase, PhaseTotals>>;
+  minHeapEver: number;
+}
+
+export interface DeviceSummary {
+  device: string;
+  reports: number;
+  firstSeen: string;
+  lastSeen: string;
+  last: TelemetryReport;
+  phases: Partial<Record<Phase, PhaseStats>>;
+  minHeapEver: number;
+  /** Average download throughput in bytes per second (0 if unknown) */
+  throughput: number;
+}
+
+const devices = new Map<string, DeviceEntry>();
+let maxDevices = 100;
+
+function isNumber(value: unknown): value is number {
+  return typeof value === "number" && Number.isFinite(value);
+}
+
+/**
+ * Validate an untrusted report body
+ * @returns The report, or null if required fields are missing or malformed
+ */
+export function parseReport(body: unknown): TelemetryReport | null {
+  if (typeof body !== "object" || body === null) {
+    return null;
+  }
+
+  const raw = body as Record<string, unknown>;
+  const heap = raw.heap as Record<string, unknown> | undefined;
+  const ms = raw.ms as Record<string, unknown> | undefined;
+
+  if (typeof raw.device !== "string" || raw.device.length === 0 || raw.device.length > 64) {
+    return null;
+  }
+  if (typeof ms !== "object" || ms === null || typeof heap !== "object" || heap === null) {
+    return null;
+  }
+
+  const phases: Partial<Record<Phase, number>> = {};
+  for (const phase of PHASES) {
+    const value = ms[phase];
+    if (isNumber(value) && value >= 0) {
+      phases[phase] = value;
+    }
+  }
+
+  return {
+    device: raw.device,
+    cycle: isNumber(raw.cycle) ? raw.cycle : 0,
+    ms: phases,
+    requests: isNumber(raw.requests) ? raw.requests : 0,
+    bytes: isNumber(raw.bytes) ? raw.bytes : 0,
+    rssi: isNumber(raw.rssi) ? raw.rssi : 0,
+    heap: {
+      free: isNumber(heap.free) ? heap.free : 0,
+      largest: isNumber(heap.largest) ? heap.largest : 0,
+      min: isNumber(heap.min) ? heap.min : 0,
+    },
+    ...(typeof raw.log === "string" ? { log: raw.log } : {}),
+  };
+}
+
+/**
+ * Add a report to its device's aggregate
+ */
+export function record(report: TelemetryReport): void {
+  let entry = devices.get(report.device);
+
+  if (!entry) {
+    if (devices.size >= maxDevices) {
+      evictOldest();
+    }
+    const now = new Date();
+    entry = { reports: 0, firstSeen: now, lastSeen: now, last: report, phases: {}, minHeapEver: report.heap.min };
+    devices.set(report.device, entry);
+  }
+
+  entry.reports++;
+  entry.lastSeen = new Date();
+  entry.last = report;
+  if (report.heap.min > 0 && (entry.minHeapEver === 0 || report.heap.min < entry.minHeapEver)) {
+    entry.minHeapEver = report.heap.min;
+  }
+
+  for (const phase of PHASES) {
+    const value = report.ms[phase];
+    if (value === undefined) {
+      continue;
+    }
+
+    const totals = entry.phases[phase];
+    if (totals) {
+      totals.count++;
+      totals.min = Math.min(totals.min, value);
+      totals.max = Math.max(totals.max, value);
+      totals.sum += value;
+    } else {
+      entry.phases[phase] = { count: 1, min: value, max: value, sum: value };
+    }
+  }
+}
+
+function summarize(device: string, entry: DeviceEntry): DeviceSummary {
+  const phases: Partial<Record<Phase, PhaseStats>> = {};
+  for (const phase of PHASES) {
+    const totals = entry.phases[phase];
+    if (totals) {
+      phases[phase] = {
+        count: totals.count,
+        min: totals.min,
+        max: totals.max,
+        avg: Math.round(totals.sum / totals.count),
+      };
+    }
+  }
+
+  const download = entry.last.ms.download;
+  return {
+    device,
+    reports: entry.reports,
+    firstSeen: entry.firstSeen.toISOString(),
+    lastSeen: entry.lastSeen.toISOString(),
+    last: entry.last,
+    phases,
+    minHeapEver: entry.minHeapEver,
+    throughput: download ? Math.round((entry.last.bytes * 1000) / download) : 0,
+  };
+}
+
+/**
+ * Aggregate for one device, or null if it never reported
+ */
+export function getDevice(device: string): DeviceSummary | null {
+  const entry = devices.get(device);
+  return entry ? summarize(device, entry) : null;
+}
+
+/**
+ * Aggregates for all devices, most recently seen first
+ */
+export function getAll(): DeviceSummary[] {
+  return Array.from(devices.entries())
+    .sort(([, a], [, b]) => b.lastSeen.getTime() - a.lastSeen.getTime())
+    .map(([device, entry]) => summarize(device, entry));
+}
+
+/**
+ * Forget all devices
+ */
+export function clear(): void {
+  devices.clear();
+}
+
+/**
+ * Set the number of devices tracked before the least recently seen is dropped
+ */
+export function setMaxDevices(count: number): void {
+  maxDevices = count;
+  while (devices.size > maxDevices) {
+    evictOldest();
+  }
+}
+
+function evictOldest(): void {
+  let oldestKey: string | null = null;
+  let oldestTime = Infinity;
+
+  for (const [key, entry] of devices.entries()) {
+    if (entry.lastSeen.getTime() < oldestTime) {
+      oldestTime = entry.lastSeen.getTime();
+      oldestKey = key;
+    }
+  }
+
+  if (oldestKey) {
+    devices.delete(oldestKey);
+  }
+}
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""
+Compare two on-device bench reports (esp32dev-bench env).
+
+Each input is a serial log or a file holding the "BENCH {...}" line; the last
+such line is used.
+
+Usage:
+    python bench_diff.py <old.log> <new.log>
+
+Example:
+    pio run -e esp32dev-bench -t upload && pio device monitor | tee new.log
+    python bench_diff.py v1.0.log new.log
+
+Prints p50/p95/p99 per phase for both firmwares and the change in percent.
+"""
+
+import json
+import sys
+
+PERCENTILES = ("p50", "p95", "p99")
+
+def load_report(filename):
+    """Return the last bench report found in the file."""
+    report = None
+    with open(filename, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            start = line.find("BENCH {")
+            if start >= 0:
+                report = json.loads(line[start + len("BENCH "):])
+    if report is None:
+        raise ValueError(f"No BENCH line in {filename}")
+    return report
+
+def change(old, new):
+    if not old:
+        return ""
+    return f"{(new - old) * 100 / old:+.0f}%"
+
+def main():
+    if len(sys.argv) != 3:
+        print("Usage: python bench_diff.py <old.log> <new.log>")
+        sys.exit(1)
+
+    old = load_report(sys.argv[1])
+    new = load_report(sys.argv[2])
+
+    print(f"old: fw {old['fw']}, {old['cycles']} cycles ({old['failed']} failed), refresh {old['refresh']}")
+    print(f"new: fw {new['fw']}, {new['cycles']} cycles ({new['failed']} failed), refresh {new['refresh']}")
+    if old["refresh"] != new["refresh"] or old["reconnect"] != new["reconnect"]:
+        print("warning: the reports were taken with different bench settings")
+    print()
+
+    print(f"{'ms':10}" + "".join(f"{p:>22}" for p in PERCENTILES))
+    for phase in new["ms"]:
+        before = old["ms"].get(phase)
+        after = new["ms"][phase]
+        if not before or not after:
+            continue
+        cells = ""
+        for p in PERCENTILES:
+            cell = f"{before[p]} -> {after[p]} {change(before[p], after[p])}"
+            cells += f"{cell:>22}"
+        print(f"{phase:10}{cells}")
+
+    print()
+    for key in ("min_free", "min_ever", "largest"):
+        before = old["heap"][key]
+        after = new["heap"][key]
+        print(f"heap {key:9} {before} -> {after} {change(before, after)}")
+
+if __name__ == "__main__":
+    main()
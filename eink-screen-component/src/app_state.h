@@ -3,22 +3,57 @@
 
 #include <config.h>
 #include <WiFiMulti.h>
+#include "http_client.h"
+#include "wifi_manager.h"
 
 // Rendering constants
-constexpr int RENDER_CHUNKS = 3;
-constexpr int BITMAP_SIZE = 800 * 480 / 8;  // Total bytes for full screen (48000 bytes)
-constexpr int CHUNK_SIZE = BITMAP_SIZE / RENDER_CHUNKS;
+constexpr int MAX_RENDER_CHUNKS = 16;              // Most bands a frame is split into on small heaps
+constexpr size_t HEAP_RESERVE_BYTES = 64 * 1024;   // Heap left free for WiFi and HTTP when sizing buffers
 constexpr int BMP_HEADER_SIZE = 62;
+constexpr int BAND_BUFFERS = 2;  // One band downloading while the other goes to the panel
+
+// Retries
+constexpr int IMAGE_RETRIES = 3;                    // Extra attempts per chunk / per streamed image
+constexpr uint32_t IMAGE_RETRY_BASE_MS = 500;       // Backoff before retry n: base * 2^(n-1) plus up to base of jitter
+constexpr uint16_t FAILED_REFRESH_RETRY_SEC = 20;   // First refresh after a failure, doubles up to refresh_interval_sec
+
+// Deep sleep
+constexpr uint32_t REFRESH_LIGHT_SLEEP_MS = 50;     // Light sleep step while the panel finishes its refresh
+
+// Heap check (HEAP_CHECK_ENABLED)
+constexpr uint8_t HEAP_CHECK_WARMUP_CYCLES = 3;     // Cycles that may still grow socket and library buffers
+constexpr uint32_t HEAP_CHECK_SLACK_BYTES = 512;    // lwIP packet buffers come and go between reads
+
+// Bench mode (BENCH_CYCLES)
+constexpr int BENCH_WARMUP_CYCLES = 1;              // Not counted: first scan, DHCP, TLS handshake and buffer growth
+constexpr uint32_t BENCH_DISCONNECT_TIMEOUT_MS = 2000;
+
+// State kept in RTC memory: survives deep sleep, cleared on power-on reset
+// Must stay plain data, constructors would wipe it on every wake
+struct RtcState {
+    char imageEtag[ETAG_MAX_LEN];  // ETag of the frame currently on the panel, empty if unknown
+    bool lastRenderSuccess;        // Track if previous image render was successful
+    uint32_t wakeCount;            // Timer wakes since power-on
+    uint8_t failedRefreshes;       // Refreshes failed in a row, shortens the next interval
+    WifiLease wifi;                // Access point and IP of the last connection
+    TlsSession tls;                // Last TLS session, resumed by the next https:// connection
+};
 
 // Centralized application state
 struct AppState {
     RemoteConfig config;
     WiFiMulti wifiMulti;
-    uint8_t bmpBuffer[CHUNK_SIZE];
+    HttpConnection http;  // Shared by config and image requests, kept alive between them
+    uint8_t* bandBuffers[BAND_BUFFERS];  // Sized at boot by UiRenderer::begin()
+    int bandBufferCount;
+    size_t bandBufferBytes;
     unsigned long lastRefreshTime;
-    bool lastRenderSuccess;  // Track if previous image render was successful
+    RtcState& rtc;
 
-    AppState() : lastRefreshTime(0), lastRenderSuccess(false) {}
+    explicit AppState(RtcState& rtcState)
+        : bandBuffers{nullptr, nullptr}, bandBufferCount(0), bandBufferBytes(0), lastRefreshTime(0), rtc(rtcState) {
+        http.tlsSession = &rtcState.tls;
+    }
 };
 
 #endif
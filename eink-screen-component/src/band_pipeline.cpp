@@ -0,0 +1,136 @@
+#include "band_pipeline.h"
+#include "logging.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+namespace BandPipeline {
+
+constexpr int BUFFER_COUNT = 2;
+// fill() may resume a dropped stream: a reconnect, and for https:// a full
+// mbedTLS handshake with the public key check, all on this task's stack
+constexpr uint32_t NETWORK_TASK_STACK = 8192;
+constexpr UBaseType_t NETWORK_TASK_PRIORITY = 1;
+
+// A filled buffer handed from the network task to the drain loop
+struct Handoff {
+    uint8_t buffer;
+    bool complete;
+};
+
+struct Job {
+    uint8_t* const* buffers;
+    int bandCount;
+    FillFn fill;
+    void* context;
+};
+
+// Created on the first run and kept: a steady-state frame allocates nothing
+static QueueHandle_t freeBuffers = nullptr;    // Buffer indices ready to be filled
+static QueueHandle_t filledBuffers = nullptr;  // Handoffs ready to be drained
+static SemaphoreHandle_t jobReady = nullptr;   // Given when job holds work for the network task
+static SemaphoreHandle_t jobDone = nullptr;    // Given when the network task is finished with it
+static Job job;
+static bool workerStarted = false;
+static UBaseType_t lowestStackFree = NETWORK_TASK_STACK;  // Bytes never touched, logged on each new low
+
+static void networkTask(void*) {
+    for (;;) {
+        xSemaphoreTake(jobReady, portMAX_DELAY);
+
+        for (int band = 0; band < job.bandCount; band++) {
+            Handoff handoff;
+            // Blocks while both buffers wait to be drained (backpressure)
+            xQueueReceive(freeBuffers, &handoff.buffer, portMAX_DELAY);
+            handoff.complete = job.fill(job.context, band, job.buffers[handoff.buffer]);
+            xQueueSend(filledBuffers, &handoff, portMAX_DELAY);
+
+            if (!handoff.complete) {
+                break;
+            }
+        }
+
+        // In bytes on the ESP32 port
+        UBaseType_t stackFree = uxTaskGetStackHighWaterMark(nullptr);
+        if (stackFree < lowestStackFree) {
+            lowestStackFree = stackFree;
+            LOG_INFO("Network task stack: %u of %u bytes never used", (unsigned)stackFree,
+                     (unsigned)NETWORK_TASK_STACK);
+        }
+
+        xSemaphoreGive(jobDone);
+    }
+}
+
+// Queues and the network task, all or nothing
+static bool startWorker() {
+    if (workerStarted) {
+        return true;
+    }
+
+    freeBuffers = xQueueCreate(BUFFER_COUNT, sizeof(uint8_t));
+    filledBuffers = xQueueCreate(BUFFER_COUNT, sizeof(Handoff));
+    jobReady = xSemaphoreCreateBinary();
+    jobDone = xSemaphoreCreateBinary();
+
+    workerStarted = freeBuffers != nullptr && filledBuffers != nullptr && jobReady != nullptr && jobDone != nullptr &&
+                    xTaskCreatePinnedToCore(networkTask, "band_net", NETWORK_TASK_STACK, nullptr,
+                                            NETWORK_TASK_PRIORITY, nullptr, NETWORK_CORE) == pdPASS;
+    if (!workerStarted) {
+        if (freeBuffers != nullptr) vQueueDelete(freeBuffers);
+        if (filledBuffers != nullptr) vQueueDelete(filledBuffers);
+        if (jobReady != nullptr) vSemaphoreDelete(jobReady);
+        if (jobDone != nullptr) vSemaphoreDelete(jobDone);
+        freeBuffers = filledBuffers = jobReady = jobDone = nullptr;
+    }
+    return workerStarted;
+}
+
+// Same work on the calling task, for a single buffer or when the pipeline cannot be set up
+static int runSequential(uint8_t* buffer, int bandCount, FillFn fill, DrainFn drain, void* context) {
+    for (int band = 0; band < bandCount; band++) {
+        if (!fill(context, band, buffer)) {
+            return band;
+        }
+        drain(context, band, buffer);
+    }
+    return bandCount;
+}
+
+int run(uint8_t* const* buffers, int bufferCount, int bandCount,
+        FillFn fill, DrainFn drain, void* context) {
+    if (bufferCount < BUFFER_COUNT) {
+        return runSequential(buffers[0], bandCount, fill, drain, context);
+    }
+    if (!startWorker()) {
+        LOG_WARN("Band pipeline unavailable, reading sequentially");
+        return runSequential(buffers[0], bandCount, fill, drain, context);
+    }
+
+    // A run that ended early may have left buffers in either queue
+    xQueueReset(freeBuffers);
+    xQueueReset(filledBuffers);
+    for (uint8_t i = 0; i < BUFFER_COUNT; i++) {
+        xQueueSend(freeBuffers, &i, 0);
+    }
+    job = {buffers, bandCount, fill, context};
+    xSemaphoreGive(jobReady);
+
+    int drained = 0;
+    for (; drained < bandCount; drained++) {
+        Handoff handoff;
+        xQueueReceive(filledBuffers, &handoff, portMAX_DELAY);
+        if (!handoff.complete) {
+            break;
+        }
+        drain(context, drained, buffers[handoff.buffer]);
+        xQueueSend(freeBuffers, &handoff.buffer, portMAX_DELAY);
+    }
+
+    // The source must not be touched by anyone else until the task is idle again
+    xSemaphoreTake(jobDone, portMAX_DELAY);
+    return drained;
+}
+
+}  // namespace BandPipeline
@@ -0,0 +1,27 @@
+#ifndef BAND_PIPELINE_H
+#define BAND_PIPELINE_H
+
+#include <Arduino.h>
+
+namespace BandPipeline {
+    // Core the network task runs on (the WiFi stack lives on core 0)
+    constexpr int NETWORK_CORE = 0;
+
+    // Fill buffer with one band from the source
+    // Returns false if the band is incomplete, which ends the pipeline
+    typedef bool (*FillFn)(void* context, int band, uint8_t* buffer);
+
+    // Consume one complete band
+    typedef void (*DrainFn)(void* context, int band, const uint8_t* buffer);
+
+    // Fill bandCount bands on a network task while the calling task drains them,
+    // so reading band N+1 overlaps with writing band N
+    // Needs two band buffers; with one the bands are read and drained in turn
+    // drain always runs on the calling task
+    // The network task and its queues are created on the first run and reused
+    // Returns the number of complete bands drained (bandCount on success)
+    int run(uint8_t* const* buffers, int bufferCount, int bandCount,
+            FillFn fill, DrainFn drain, void* context);
+}
+
+#endif
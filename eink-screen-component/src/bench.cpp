@@ -0,0 +1,145 @@
+#include "bench.h"
+#include "logging.h"
+#include "app_state.h"
+#include "wifi_manager.h"
+#include "config_manager.h"
+#include "display_driver.h"
+#include "ui_renderer.h"
+#include "telemetry.h"
+#include <WiFi.h>
+
+#if BENCH_CYCLES > 0
+
+namespace Bench {
+
+// Metrics per cycle: the telemetry phases, then these
+enum Metric {
+    METRIC_PANEL = Telemetry::PHASE_COUNT,  // Waiting for the queued refresh to finish on the panel
+    METRIC_TOTAL,
+    METRIC_COUNT
+};
+
+// Indexed by BENCH_REFRESH, in UiRenderer::RefreshMode order
+static const char* REFRESH_NAMES[] = {"auto", "window", "none"};
+static_assert(BENCH_REFRESH >= 0 && BENCH_REFRESH <= 2, "BENCH_REFRESH must be 0, 1 or 2");
+
+// Samples of the successful cycles, one column per metric
+static uint32_t samples[METRIC_COUNT][BENCH_CYCLES];
+
+static const char* metricName(int metric) {
+    if (metric == METRIC_PANEL) return "panel";
+    if (metric == METRIC_TOTAL) return "total";
+    return Telemetry::phaseName((Telemetry::Phase)metric);
+}
+
+static void dropWifi(AppState& state) {
+    state.http.close();
+    WiFi.disconnect();
+    unsigned long startMs = millis();
+    while (WifiManager::isConnected() && millis() - startMs < BENCH_DISCONNECT_TIMEOUT_MS) {
+        delay(10);
+    }
+}
+
+// One refresh cycle as loop() runs it, without the telemetry report
+// Returns false if WiFi or the image failed
+static bool cycle(AppState& state, uint32_t* metrics) {
+    if (BENCH_RECONNECT) {
+        dropWifi(state);
+    }
+    state.rtc.imageEtag[0] = '\0';
+
+    Telemetry::beginCycle();
+    unsigned long startMs = millis();
+    bool ok = WifiManager::ensureConnected(state.wifiMulti, state.rtc.wifi);
+    if (ok) {
+        ConfigManager::loadRemoteConfig(state.config, state.http);
+        ok = UiRenderer::showRemoteImage(state);
+    }
+
+    unsigned long panelStartMs = millis();
+    DisplayDriver::waitUntilIdle();
+    unsigned long endMs = millis();
+
+    for (int i = 0; i < Telemetry::PHASE_COUNT; i++) {
+        metrics[i] = Telemetry::phaseMs((Telemetry::Phase)i);
+    }
+    metrics[METRIC_PANEL] = endMs - panelStartMs;
+    metrics[METRIC_TOTAL] = endMs - startMs;
+    return ok;
+}
+
+static int compareSamples(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+// Nearest-rank percentile of sorted values
+static uint32_t percentile(const uint32_t* sorted, int count, int percent) {
+    int rank = (percent * count + 99) / 100;
+    return sorted[max(rank, 1) - 1];
+}
+
+static void printReport(int measured, int failed, uint32_t minFreeHeap) {
+    // Straight to Serial after the log: the report is longer than a log line
+    Log::flush();
+    Serial.printf("BENCH {\"fw\":\"%s\",\"panel\":\"%s\",\"cycles\":%d,\"failed\":%d,\"refresh\":\"%s\","
+                  "\"reconnect\":%d,\"ms\":{",
+                  FIRMWARE_VERSION, EPD_PANEL_NAME, measured, failed, REFRESH_NAMES[BENCH_REFRESH],
+                  BENCH_RECONNECT);
+
+    int count = measured - failed;
+    for (int metric = 0; metric < METRIC_COUNT; metric++) {
+        uint32_t* values = samples[metric];
+        qsort(values, count, sizeof(uint32_t), compareSamples);
+        Serial.printf("%s\"%s\":", metric > 0 ? "," : "", metricName(metric));
+        if (count == 0) {
+            Serial.printf("null");
+            continue;
+        }
+        Serial.printf("{\"min\":%u,\"p50\":%u,\"p95\":%u,\"p99\":%u,\"max\":%u}",
+                      (unsigned)values[0], (unsigned)percentile(values, count, 50),
+                      (unsigned)percentile(values, count, 95), (unsigned)percentile(values, count, 99),
+                      (unsigned)values[count - 1]);
+    }
+
+    Serial.printf("},\"heap\":{\"min_free\":%u,\"min_ever\":%u,\"largest\":%u}}\n",
+                  (unsigned)minFreeHeap, (unsigned)ESP.getMinFreeHeap(), (unsigned)ESP.getMaxAllocHeap());
+    Serial.flush();
+}
+
+void run(AppState& state) {
+    UiRenderer::setRefreshMode((UiRenderer::RefreshMode)BENCH_REFRESH);
+    LOG_INFO("Bench: %d warm-up and %d measured cycles, refresh %s", BENCH_WARMUP_CYCLES, BENCH_CYCLES,
+             REFRESH_NAMES[BENCH_REFRESH]);
+
+    // Connects as setup() does; the warm-up cycles run after it
+    WifiManager::setup(state.wifiMulti, state.rtc.wifi);
+    uint32_t metrics[METRIC_COUNT];
+    for (int i = 0; i < BENCH_WARMUP_CYCLES; i++) {
+        cycle(state, metrics);
+    }
+
+    int failed = 0;
+    uint32_t minFreeHeap = ESP.getFreeHeap();
+    for (int i = 0; i < BENCH_CYCLES; i++) {
+        bool ok = cycle(state, metrics);
+        minFreeHeap = min(minFreeHeap, (uint32_t)ESP.getFreeHeap());
+        LOG_INFO("Bench cycle %d/%d: %u ms%s", i + 1, BENCH_CYCLES, (unsigned)metrics[METRIC_TOTAL],
+                 ok ? "" : " (failed)");
+        if (!ok) {
+            failed++;
+            continue;
+        }
+        for (int metric = 0; metric < METRIC_COUNT; metric++) {
+            samples[metric][i - failed] = metrics[metric];
+        }
+    }
+
+    printReport(BENCH_CYCLES, failed, minFreeHeap);
+}
+
+}  // namespace Bench
+
+#endif
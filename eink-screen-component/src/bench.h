@@ -0,0 +1,20 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "config.h"
+
+struct AppState;
+
+// On-device benchmark (BENCH_CYCLES > 0)
+// Runs the production refresh cycle - WifiManager, ConfigManager,
+// UiRenderer::showRemoteImage() - back to back on real hardware, with the
+// image ETag cleared so every cycle downloads and draws the frame. Each cycle
+// also waits for the panel waveform, timed as "panel". The report is one line:
+//   BENCH {"fw":...,"ms":{"wifi":{"min":..,"p50":..,"p95":..,"p99":..,"max":..},...},"heap":{...}}
+// Compare two reports with bench_diff.py
+namespace Bench {
+    // Run BENCH_WARMUP_CYCLES, then BENCH_CYCLES measured cycles, and print the report
+    void run(AppState& state);
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "change_watcher.h"
+#include "logging.h"
+
+namespace ChangeWatcher {
+
+// Token of the entity states the panel was last refreshed for
+static char token[ETAG_MAX_LEN];
+static uint32_t retryAt = 0;
+
+bool enabled(const RemoteConfig& config) {
+    return CHANGE_WAIT_ENABLED && config.changesPath.length() > 0 && config.imageTemplate.length() > 0;
+}
+
+bool waitForChange(const RemoteConfig& config, HttpConnection& http, uint32_t maxWaitMs) {
+    if (retryAt != 0 && (int32_t)(millis() - retryAt) < 0) {
+        return false;
+    }
+    retryAt = 0;
+
+    uint16_t waitSec = min((uint32_t)min(config.changesTimeoutSec, MAX_WAIT_SEC), maxWaitMs / 1000);
+    if (waitSec == 0 && token[0] != '\0') {
+        return false;
+    }
+
+    char url[URL_MAX_LEN];
+    snprintf(url, sizeof(url), "%s%s?template=%s&timeout=%u", config.imageBaseUrl.c_str(),
+             config.changesPath.c_str(), config.imageTemplate.c_str(), (unsigned)waitSec);
+
+    // Leave the server time to answer 304 before the read times out
+    if (!http.begin(url, (waitSec + 10) * 1000)) {
+        return false;
+    }
+    if (token[0] != '\0') {
+        http.setIfNoneMatch(token);
+    }
+
+    int httpCode = http.get();
+
+    if (httpCode == 304) {
+        http.end();
+        return false;
+    }
+
+    if (httpCode != 200) {
+        LOG_WARN("Change wait failed (%d), polling every refresh interval for now", httpCode);
+        http.close();
+        retryAt = millis() + RETRY_AFTER_MS;
+        return false;
+    }
+
+    bool first = token[0] == '\0';
+    bool changed = strcmp(token, http.getETag()) != 0;
+    strcpy(token, http.getETag());
+    http.discardBody();  // Small JSON body, read it so the socket can be reused
+    http.end();
+
+    if (first) {
+        LOG_INFO("Watching template entities (token %s)", token);
+        return false;
+    }
+    return changed;
+}
+
+}  // namespace ChangeWatcher
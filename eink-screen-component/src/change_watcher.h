@@ -0,0 +1,24 @@
+#ifndef CHANGE_WATCHER_H
+#define CHANGE_WATCHER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "http_client.h"
+
+namespace ChangeWatcher {
+    // Longest single wait; HTTPClient read timeouts are 16-bit milliseconds
+    constexpr uint16_t MAX_WAIT_SEC = 50;
+
+    // After a failed wait, fall back to plain interval polling for this long
+    constexpr uint32_t RETRY_AFTER_MS = 60000;
+
+    // True if the server offers change notification (changes.path in /config)
+    bool enabled(const RemoteConfig& config);
+
+    // Hold a long-poll on {base_url}{changes.path} for up to maxWaitMs
+    // Returns true as soon as an entity used by the template changed,
+    // false on timeout, error, or the first call (which only fetches the token)
+    bool waitForChange(const RemoteConfig& config, HttpConnection& http, uint32_t maxWaitMs);
+}
+
+#endif
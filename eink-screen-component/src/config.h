@@ -8,8 +8,90 @@
 #include "secrets.h"
 
 // Default Server Configuration (can be overridden by remote config)
+// Set it in secrets.h or as a build flag, e.g. for HTTPS:
+//   '-DDEFAULT_BASE_URL="https://renderer.example.com"'
+#ifndef DEFAULT_BASE_URL
 #define DEFAULT_BASE_URL "http://192.168.0.129:8000"
+#endif
 #define CONFIG_PATH "/config"
+#define TELEMETRY_PATH "/telemetry"
+
+// Firmware version, sent with the config request
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "1.1.0"
+#endif
+
+// Image formats the renderer can draw, best first; the server picks one
+#define IMAGE_FORMATS "rle,epd1,bmp"
+
+// HTTPS (https:// base_url)
+// SHA-256 of the server's public key (DER SubjectPublicKeyInfo) in hex; list
+// several separated by commas to pin a backup key before rotating. Set it in
+// secrets.h or as a build flag; https:// URLs are refused without a pin
+#ifndef TLS_PINS
+#define TLS_PINS ""
+#endif
+
+// Telemetry
+// 1 = POST per-cycle timings and heap stats to {base_url}/telemetry after each refresh
+#ifndef TELEMETRY_ENABLED
+#define TELEMETRY_ENABLED 1
+#endif
+
+// Logging (see logging.h)
+// Lines above LOG_LEVEL compile to nothing. Debug adds per-chunk progress,
+// full URLs and the parsed config; build with -DLOG_LEVEL=4 to see them
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// 1 = log lines go through a RAM ring buffer that an idle-priority task writes
+// to Serial, so a refresh never waits on the 115200 baud console; lines are
+// dropped (and counted) when it is full. 0 = write to Serial directly
+#ifndef LOG_BUFFER_ENABLED
+#define LOG_BUFFER_ENABLED 1
+#endif
+#ifndef LOG_BUFFER_SIZE
+#define LOG_BUFFER_SIZE 4096
+#endif
+
+// Bytes of the newest log lines attached to each telemetry report as "log"
+// 0 = none, at most 1800 so the report stays within the server's 4 KB
+// body limit; needs LOG_BUFFER_ENABLED
+#ifndef LOG_TELEMETRY_BYTES
+#define LOG_TELEMETRY_BYTES 0
+#endif
+
+// Heap Check (debug)
+// 1 = after each refresh cycle of a stay-awake build, compare free heap with
+// the level after warm-up and log any cycle that kept memory
+#ifndef HEAP_CHECK_ENABLED
+#define HEAP_CHECK_ENABLED 0
+#endif
+
+// Bench Mode (on-device benchmark)
+// N > 0 = instead of refreshing on the interval, run N WiFi, config and image
+// cycles back to back, then print latency percentiles per phase and the
+// lowest free heap as one JSON line starting with "BENCH " (see bench.h)
+#ifndef BENCH_CYCLES
+#define BENCH_CYCLES 0
+#endif
+
+// Panel refresh in bench cycles: 0 = as in production, 1 = one fast partial
+// window over the frame, 2 = none (controller RAM writes only)
+#ifndef BENCH_REFRESH
+#define BENCH_REFRESH 0
+#endif
+
+// 1 = drop WiFi before each bench cycle so the reconnect is measured too
+#ifndef BENCH_RECONNECT
+#define BENCH_RECONNECT 1
+#endif
 
 // SPI Pin Configuration (Waveshare ESP32 Driver Board defaults)
 // Modify these values if using different pins
@@ -18,6 +100,97 @@
 #define SPI_MOSI 14
 #define SPI_SS 15
 
+// Panel control pins (Waveshare ESP32 Driver Board)
+#ifndef EPD_CS
+#define EPD_CS 15
+#endif
+#ifndef EPD_DC
+#define EPD_DC 27
+#endif
+#ifndef EPD_RST
+#define EPD_RST 26
+#endif
+#ifndef EPD_BUSY
+#define EPD_BUSY 25
+#endif
+
+// Display Configuration
+// Black and white GxEPD2 driver class and its header, chosen per build env, e.g.
+//   -DEPD_PANEL=GxEPD2_750_T7 '-DEPD_PANEL_HEADER="epd/GxEPD2_750_T7.h"'
+// Panel size, frame bytes and band geometry are all derived from the class
+// at compile time (see DisplayDriver::WIDTH); the default is the 7.5" B/W V2
+// (GDEY075T7, 800x480) on the Waveshare ESP32 Driver Board
+#ifndef EPD_PANEL
+#define EPD_PANEL GxEPD2_750_GDEY075T7
+#define EPD_PANEL_HEADER <gdey/GxEPD2_750_GDEY075T7.h>
+#endif
+
+#include <GxEPD2_BW.h>
+#include EPD_PANEL_HEADER
+
+// Panel class name as text, reported to the server with the config request
+#define EPD_STRINGIFY_(x) #x
+#define EPD_STRINGIFY(x) EPD_STRINGIFY_(x)
+#define EPD_PANEL_NAME EPD_STRINGIFY(EPD_PANEL)
+
+// Display buffer size for ESP32
+#define MAX_DISPLAY_BUFFER_SIZE 65536ul
+#define MAX_HEIGHT(EPD) (EPD::HEIGHT <= MAX_DISPLAY_BUFFER_SIZE / (EPD::WIDTH / 8) ? EPD::HEIGHT : MAX_DISPLAY_BUFFER_SIZE / (EPD::WIDTH / 8))
+
+// Refresh Scheduling
+// 1 = deep sleep between refreshes (battery units), 0 = stay awake and poll
+// Can be overridden from platformio.ini with -DDEEP_SLEEP_ENABLED=1
+#ifndef DEEP_SLEEP_ENABLED
+#define DEEP_SLEEP_ENABLED 0
+#endif
+
+// Change Notification
+// 1 = between refreshes, long-poll {base_url}{changes.path} and refresh as soon as
+// an entity used by the template changes (stay-awake builds only)
+#ifndef CHANGE_WAIT_ENABLED
+#define CHANGE_WAIT_ENABLED 1
+#endif
+
+// Frame Cache
+// 1 = keep the last good frame in LittleFS (the default "spiffs" partition) and
+// show it at power-on before WiFi is up, and instead of an error screen when
+// the server cannot be reached. Costs one frame write (48 KB on an 800x480 panel) per new image
+#ifndef FRAME_CACHE_ENABLED
+#define FRAME_CACHE_ENABLED 1
+#endif
+
+// Layout Regions
+// Rectangles of the display fetched and partially refreshed on their own
+// interval over the full image (stay-awake builds only, they need FrameDiff)
+#define MAX_REGIONS 8
+
+struct LayoutRegion
+{
+  uint16_t x;  // Multiple of 8, like width: rows start on a byte of panel RAM
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+  uint16_t intervalSec;
+  String templateName;
+};
+
+// Text Overlays
+// Text slots the device renders itself from its NTP-synced clock, e.g. the
+// time, drawn into a small partial window over the image (stay-awake builds only)
+#define MAX_OVERLAYS 4
+#define DEFAULT_NTP_SERVER "pool.ntp.org"
+
+struct OverlaySlot
+{
+  uint16_t x;  // Multiple of 8, like width
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+  uint8_t font;    // Point size of the bundled FreeMonoBold font: 9, 12, 18 or 24
+  char align;      // 'l', 'c' or 'r' within the slot
+  String format;   // strftime() format, e.g. "%H:%M"
+};
+
 // Remote Config Structure
 struct RemoteConfig
 {
@@ -27,9 +200,22 @@ struct RemoteConfig
   uint16_t imageThreshold;
   String imageUrl;
   String imageTemplate;
+  bool imageStream;  // Fetch the whole bitmap in one request instead of per-chunk requests
   uint16_t displayWidth;
   uint16_t displayHeight;
   uint16_t refreshIntervalSec;
+  uint16_t partialRefreshCycles; // Fast partial refreshes between full ones, 0 = always full
+  uint16_t fullRefreshMinutes;   // Longest time between full refreshes, 0 = no limit
+  String changesPath;         // Long-poll endpoint for entity changes, empty if the server has none
+  uint16_t changesTimeoutSec; // Longest the server holds a change request
+  LayoutRegion regions[MAX_REGIONS];
+  uint8_t regionCount;        // 0 = the full image is the only content
+  OverlaySlot overlays[MAX_OVERLAYS];
+  uint8_t overlayCount;
+  String timeZone;            // POSIX TZ string for the overlays, e.g. "EET-2EEST,M3.5.0/3,M10.5.0/4"
+  String ntpServer;
+  String etag;  // Validator of the /config response this was parsed from, empty if unknown
+  uint32_t revision;  // Bumped when the fields change, so URLs built from them are rebuilt
 
   // Constructor with defaults
   RemoteConfig() : imageBaseUrl(DEFAULT_BASE_URL),
@@ -38,20 +224,22 @@ struct RemoteConfig
                    imageThreshold(128),
                    imageUrl(""),
                    imageTemplate(""),
-                   displayWidth(800),
-                   displayHeight(480),
-                   refreshIntervalSec(60)
+                   imageStream(true),
+                   displayWidth(EPD_PANEL::WIDTH),
+                   displayHeight(EPD_PANEL::HEIGHT),
+                   refreshIntervalSec(60),
+                   partialRefreshCycles(10),
+                   fullRefreshMinutes(60),
+                   changesPath(""),
+                   changesTimeoutSec(50),
+                   regionCount(0),
+                   overlayCount(0),
+                   timeZone("UTC0"),
+                   ntpServer(DEFAULT_NTP_SERVER),
+                   etag(""),
+                   revision(0)
   {
   }
 };
 
-// Display Configuration
-// 7.5" B/W V2 Display (800x480) with Waveshare ESP32 Driver Board
-#include <GxEPD2_BW.h>
-#include <gdey/GxEPD2_750_GDEY075T7.h>
-
-// Display buffer size for ESP32
-#define MAX_DISPLAY_BUFFER_SIZE 65536ul
-#define MAX_HEIGHT(EPD) (EPD::HEIGHT <= MAX_DISPLAY_BUFFER_SIZE / (EPD::WIDTH / 8) ? EPD::HEIGHT : MAX_DISPLAY_BUFFER_SIZE / (EPD::WIDTH / 8))
-
 #endif
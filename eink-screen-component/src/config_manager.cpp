@@ -1,46 +1,201 @@
 #include "config_manager.h"
+#include "logging.h"
+#include "config_store.h"
+#include "display_driver.h"
+#include "frame_diff.h"
 #include "http_client.h"
+#include "telemetry.h"
 #include <ArduinoJson.h>
 
 namespace ConfigManager {
 
-bool loadRemoteConfig(RemoteConfig& config) {
-    String url = config.imageBaseUrl + CONFIG_PATH;
-    Serial.printf("Loading config from: %s\n", url.c_str());
+// Only the fields RemoteConfig uses are kept while parsing
+static void buildFilter(JsonDocument& filter) {
+    JsonObject image = filter["image"].to<JsonObject>();
+    image["base_url"] = true;
+    image["path"] = true;
+    image["stream"] = true;
+
+    JsonObject params = image["parameters"].to<JsonObject>();
+    params["format"] = true;
+    params["threshold"] = true;
+    params["url"] = true;
+    params["template"] = true;
+
+    JsonObject display = filter["display"].to<JsonObject>();
+    display["width"] = true;
+    display["height"] = true;
+    display["refresh_interval_sec"] = true;
+    display["partial_refresh_cycles"] = true;
+    display["full_refresh_minutes"] = true;
+
+    JsonObject changes = filter["changes"].to<JsonObject>();
+    changes["path"] = true;
+    changes["timeout_sec"] = true;
+
+    // A filter on the first element applies to every element of the array
+    JsonObject region = filter["regions"][0].to<JsonObject>();
+    region["x"] = true;
+    region["y"] = true;
+    region["width"] = true;
+    region["height"] = true;
+    region["interval_sec"] = true;
+    region["template"] = true;
+
+    JsonObject overlay = filter["overlays"][0].to<JsonObject>();
+    overlay["x"] = true;
+    overlay["y"] = true;
+    overlay["width"] = true;
+    overlay["height"] = true;
+    overlay["font"] = true;
+    overlay["align"] = true;
+    overlay["format"] = true;
+
+    JsonObject time = filter["time"].to<JsonObject>();
+    time["timezone"] = true;
+    time["ntp_server"] = true;
+}
+
+// Keep the regions the band writer can place: byte-aligned and on the panel
+static void parseRegions(JsonArray regions, RemoteConfig& config) {
+    config.regionCount = 0;
+    for (JsonObject region : regions) {
+        if (config.regionCount == MAX_REGIONS) {
+            LOG_WARN("More than %d regions, ignoring the rest", MAX_REGIONS);
+            break;
+        }
+
+        LayoutRegion parsed;
+        parsed.x = region["x"] | 0;
+        parsed.y = region["y"] | 0;
+        parsed.width = region["width"] | 0;
+        parsed.height = region["height"] | 0;
+        parsed.intervalSec = region["interval_sec"] | 0;
+        parsed.templateName = region["template"] | "";
+
+        bool aligned = parsed.x % 8 == 0 && parsed.width % 8 == 0;
+        bool onPanel = parsed.width > 0 && parsed.height > 0 &&
+                       parsed.x + parsed.width <= config.displayWidth &&
+                       parsed.y + parsed.height <= config.displayHeight;
+        if (!aligned || !onPanel || parsed.intervalSec == 0 || parsed.templateName.length() == 0) {
+            LOG_WARN("Skipping region %dx%d at (%d,%d)", parsed.width, parsed.height, parsed.x, parsed.y);
+            continue;
+        }
+        config.regions[config.regionCount++] = parsed;
+    }
+}
+
+// Same placement rules as regions; unknown fonts fall back to 12 pt
+static void parseOverlays(JsonArray overlays, RemoteConfig& config) {
+    config.overlayCount = 0;
+    for (JsonObject overlay : overlays) {
+        if (config.overlayCount == MAX_OVERLAYS) {
+            LOG_WARN("More than %d overlays, ignoring the rest", MAX_OVERLAYS);
+            break;
+        }
+
+        OverlaySlot parsed;
+        parsed.x = overlay["x"] | 0;
+        parsed.y = overlay["y"] | 0;
+        parsed.width = overlay["width"] | 0;
+        parsed.height = overlay["height"] | 0;
+        parsed.font = overlay["font"] | 12;
+        parsed.align = (overlay["align"] | "left")[0];
+        parsed.format = overlay["format"] | "";
+
+        bool aligned = parsed.x % 8 == 0 && parsed.width % 8 == 0;
+        bool onPanel = parsed.width > 0 && parsed.height > 0 &&
+                       parsed.x + parsed.width <= config.displayWidth &&
+                       parsed.y + parsed.height <= config.displayHeight;
+        if (!aligned || !onPanel || parsed.format.length() == 0) {
+            LOG_WARN("Skipping overlay %dx%d at (%d,%d)", parsed.width, parsed.height, parsed.x, parsed.y);
+            continue;
+        }
+        if (parsed.align != 'c' && parsed.align != 'r') {
+            parsed.align = 'l';
+        }
+        config.overlays[config.overlayCount++] = parsed;
+    }
+}
+
+// The config request carries what this board can do, so the server can pick
+// the format, render size and refresh policy for it
+// Partial refreshes need the frame copy, which only stay-awake builds keep
+static int buildConfigUrl(const RemoteConfig& config, char* url, size_t size) {
+    bool partial = DisplayDriver::Panel::hasFastPartialUpdate && FrameDiff::enabled();
+    return snprintf(url, size,
+                    "%s%s?panel=%s&width=%d&height=%d&heap=%u&psram=%u&formats=%s&partial=%d&sleep=%d&fw=%s",
+                    config.imageBaseUrl.c_str(), CONFIG_PATH, EPD_PANEL_NAME,
+                    DisplayDriver::WIDTH, DisplayDriver::HEIGHT,
+                    (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getPsramSize(), IMAGE_FORMATS,
+                    partial ? 1 : 0, DEEP_SLEEP_ENABLED, FIRMWARE_VERSION);
+}
+
+bool setBaseUrl(RemoteConfig& config, const String& baseUrl) {
+    if (config.imageBaseUrl.startsWith("https://") && !baseUrl.startsWith("https://")) {
+        LOG_WARN("Ignoring base_url %s, staying on HTTPS", baseUrl.c_str());
+        return false;
+    }
+    config.imageBaseUrl = baseUrl;
+    return true;
+}
+
+bool loadRemoteConfig(RemoteConfig& config, HttpConnection& http) {
+    Telemetry::PhaseTimer timer(Telemetry::PHASE_CONFIG);
+    char url[URL_MAX_LEN];
+    int len = buildConfigUrl(config, url, sizeof(url));
+    if (len < 0 || (size_t)len >= sizeof(url)) {
+        LOG_ERROR("Config URL too long");
+        return false;
+    }
+    LOG_DEBUG("Loading config from: %s", url);
 
-    HttpConnection http;
     if (!http.begin(url)) {
-        Serial.println("http.begin() failed for config (WiFi not connected?)");
+        LOG_ERROR("http.begin() failed for config (WiFi not connected?)");
         return false;
     }
 
+    if (config.etag.length() > 0) {
+        http.setIfNoneMatch(config.etag.c_str());
+    }
+
     int httpCode = http.get();
-    Serial.printf("Config HTTP response: %d\n", httpCode);
+    LOG_DEBUG("Config HTTP response: %d", httpCode);
 
-    if (httpCode != 200) {
+    if (httpCode == 304) {
         http.end();
-        Serial.println("Failed to load config, using defaults");
+        LOG_INFO("Config unchanged");
+        return true;
+    }
+
+    if (httpCode != 200) {
+        http.close();
+        LOG_WARN("Failed to load config, keeping current config");
         return false;
     }
 
-    String payload = http.getResponseString();
-    Serial.printf("Config payload: %s\n", payload.c_str());
+    // Parse straight from the socket; needs Content-Length (no chunked encoding)
+    JsonDocument filter;
+    buildFilter(filter);
 
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, payload);
+    DeserializationError error = deserializeJson(doc, *http.getStream(), DeserializationOption::Filter(filter));
 
     if (error) {
-        Serial.printf("JSON parse error: %s\n", error.c_str());
-        http.end();
+        LOG_ERROR("JSON parse error: %s", error.c_str());
+        http.close();
         return false;
     }
 
-    // Update config from JSON
+    // Update config from JSON; URLs built from the old values are rebuilt
+    config.revision++;
     if (doc.containsKey("image")) {
         if (doc["image"].containsKey("base_url"))
-            config.imageBaseUrl = doc["image"]["base_url"].as<String>();
+            setBaseUrl(config, doc["image"]["base_url"].as<String>());
         if (doc["image"].containsKey("path"))
             config.imagePath = doc["image"]["path"].as<String>();
+        if (doc["image"].containsKey("stream"))
+            config.imageStream = doc["image"]["stream"];
 
         if (doc["image"].containsKey("parameters")) {
             JsonObject params = doc["image"]["parameters"];
@@ -62,49 +217,111 @@ bool loadRemoteConfig(RemoteConfig& config) {
             config.displayHeight = doc["display"]["height"];
         if (doc["display"].containsKey("refresh_interval_sec"))
             config.refreshIntervalSec = doc["display"]["refresh_interval_sec"];
+        if (doc["display"].containsKey("partial_refresh_cycles"))
+            config.partialRefreshCycles = doc["display"]["partial_refresh_cycles"];
+        if (doc["display"].containsKey("full_refresh_minutes"))
+            config.fullRefreshMinutes = doc["display"]["full_refresh_minutes"];
     }
 
-    Serial.println("Config loaded successfully:");
-    Serial.printf("  Image URL: %s%s\n", config.imageBaseUrl.c_str(), config.imagePath.c_str());
-    Serial.printf("  Image params - format: %s, threshold: %d\n",
-                  config.imageFormat.c_str(), config.imageThreshold);
+    // Older servers have no change endpoint; the device then only polls
+    config.changesPath = doc["changes"]["path"] | "";
+    config.changesTimeoutSec = doc["changes"]["timeout_sec"] | config.changesTimeoutSec;
+
+    // Without a layout the full image is the only content
+    parseRegions(doc["regions"].as<JsonArray>(), config);
+    parseOverlays(doc["overlays"].as<JsonArray>(), config);
+    config.timeZone = doc["time"]["timezone"] | "UTC0";
+    config.ntpServer = doc["time"]["ntp_server"] | DEFAULT_NTP_SERVER;
+
+    LOG_INFO("Config loaded successfully:");
+    LOG_DEBUG("  Image URL: %s%s", config.imageBaseUrl.c_str(), config.imagePath.c_str());
+    LOG_DEBUG("  Image params - format: %s, threshold: %d",
+              config.imageFormat.c_str(), config.imageThreshold);
+    LOG_DEBUG("  Transfer: %s", config.imageStream ? "single stream" : "chunked");
     if (config.imageUrl.length() > 0) {
-        Serial.printf("  Image URL param: %s\n", config.imageUrl.c_str());
+        LOG_DEBUG("  Image URL param: %s", config.imageUrl.c_str());
     }
     if (config.imageTemplate.length() > 0) {
-        Serial.printf("  Template: %s\n", config.imageTemplate.c_str());
+        LOG_DEBUG("  Template: %s", config.imageTemplate.c_str());
+    }
+    LOG_DEBUG("  Display: %dx%d", config.displayWidth, config.displayHeight);
+    LOG_DEBUG("  Refresh interval: %d sec", config.refreshIntervalSec);
+    LOG_DEBUG("  Full refresh: every %d partial refreshes / %d min",
+              config.partialRefreshCycles, config.fullRefreshMinutes);
+    if (config.changesPath.length() > 0) {
+        LOG_DEBUG("  Change wait: %s (%d sec)", config.changesPath.c_str(), config.changesTimeoutSec);
+    }
+    for (int i = 0; i < config.regionCount; i++) {
+        const LayoutRegion& region = config.regions[i];
+        LOG_DEBUG("  Region %d: %s %dx%d at (%d,%d) every %d sec", i + 1, region.templateName.c_str(),
+                  region.width, region.height, region.x, region.y, region.intervalSec);
+    }
+    for (int i = 0; i < config.overlayCount; i++) {
+        const OverlaySlot& overlay = config.overlays[i];
+        LOG_DEBUG("  Overlay %d: \"%s\" %dpt %dx%d at (%d,%d)", i + 1, overlay.format.c_str(),
+                  overlay.font, overlay.width, overlay.height, overlay.x, overlay.y);
+    }
+    if (config.overlayCount > 0) {
+        LOG_DEBUG("  Time: %s via %s", config.timeZone.c_str(), config.ntpServer.c_str());
     }
-    Serial.printf("  Display: %dx%d\n", config.displayWidth, config.displayHeight);
-    Serial.printf("  Refresh interval: %d sec\n", config.refreshIntervalSec);
 
+    // A new version is cached so the next boot can skip this request
+    const char* etag = http.getETag();
     http.end();
+
+    if (etag[0] != '\0' && config.etag != etag) {
+        config.etag = etag;
+        ConfigStore::save(config);
+    }
     return true;
 }
 
-String buildImageUrl(const RemoteConfig& config, int chunkOffsetBytes, int chunkLimitBytes) {
-    char url[2048];
+int buildImageUrl(const RemoteConfig& config, char* url, size_t size) {
+    int len;
 
     if (config.imageTemplate.length() > 0) {
-        snprintf(url, sizeof(url), "%s%s?format=%s&threshold=%d&template=%s&offset=%d&limit=%d",
-                 config.imageBaseUrl.c_str(),
-                 config.imagePath.c_str(),
-                 config.imageFormat.c_str(),
-                 config.imageThreshold,
-                 config.imageTemplate.c_str(),
-                 chunkOffsetBytes,
-                 chunkLimitBytes);
+        len = snprintf(url, size, "%s%s?format=%s&threshold=%d&template=%s&width=%d&height=%d",
+                       config.imageBaseUrl.c_str(),
+                       config.imagePath.c_str(),
+                       config.imageFormat.c_str(),
+                       config.imageThreshold,
+                       config.imageTemplate.c_str(),
+                       config.displayWidth,
+                       config.displayHeight);
     } else {
-        snprintf(url, sizeof(url), "%s%s?url=%s&format=%s&threshold=%d&offset=%d&limit=%d",
-                 config.imageBaseUrl.c_str(),
-                 config.imagePath.c_str(),
-                 config.imageUrl.c_str(),
-                 config.imageFormat.c_str(),
-                 config.imageThreshold,
-                 chunkOffsetBytes,
-                 chunkLimitBytes);
+        len = snprintf(url, size, "%s%s?url=%s&format=%s&threshold=%d&width=%d&height=%d",
+                       config.imageBaseUrl.c_str(),
+                       config.imagePath.c_str(),
+                       config.imageUrl.c_str(),
+                       config.imageFormat.c_str(),
+                       config.imageThreshold,
+                       config.displayWidth,
+                       config.displayHeight);
+    }
+
+    // Leave room for the range of a chunk request
+    if (len < 0 || len + RANGE_QUERY_MAX_LEN >= size) {
+        LOG_ERROR("Image URL too long");
+        url[0] = '\0';
+        return 0;
     }
+    return len;
+}
 
-    return String(url);
+int buildRegionUrl(const RemoteConfig& config, const LayoutRegion& region, char* url, size_t size) {
+    int len = snprintf(url, size, "%s%s?format=epd1&threshold=%d&template=%s&width=%d&height=%d",
+                       config.imageBaseUrl.c_str(),
+                       config.imagePath.c_str(),
+                       config.imageThreshold,
+                       region.templateName.c_str(),
+                       region.width,
+                       region.height);
+    if (len < 0 || (size_t)len >= size) {
+        LOG_ERROR("Region URL too long");
+        url[0] = '\0';
+        return 0;
+    }
+    return len;
 }
 
 }  // namespace ConfigManager
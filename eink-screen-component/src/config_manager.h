@@ -2,16 +2,32 @@
 #define CONFIG_MANAGER_H
 
 #include "config.h"
+#include "http_client.h"
 
 namespace ConfigManager {
-    // Load configuration from remote server
+    // Load configuration from remote server over the shared connection
     // Updates the provided config struct
     // Returns true on success
-    bool loadRemoteConfig(RemoteConfig& config);
+    bool loadRemoteConfig(RemoteConfig& config, HttpConnection& http);
 
-    // Build the full image URL with all parameters
-    // Returns URL string for the specified chunk
-    String buildImageUrl(const RemoteConfig& config, int chunkOffsetBytes, int chunkLimitBytes);
+    // Take baseUrl as the server URL unless it would move an https:// device
+    // to plain http://, which would leave TLS protecting nothing but /config
+    // Returns false if it was refused
+    bool setBaseUrl(RemoteConfig& config, const String& baseUrl);
+
+    // Longest "&offset=...&limit=..." a chunk request appends to the image URL
+    constexpr size_t RANGE_QUERY_MAX_LEN = 32;
+
+    // Write the full image URL with all parameters into url (size bytes),
+    // leaving room for a chunk range to be appended
+    // Build it once per config revision; no heap is used
+    // Returns its length, 0 if it does not fit
+    int buildImageUrl(const RemoteConfig& config, char* url, size_t size);
+
+    // Write the URL of one layout region, rendered at the region's size
+    // Always epd1: raw panel rows, read straight into the band buffer
+    // Returns its length, 0 if it does not fit
+    int buildRegionUrl(const RemoteConfig& config, const LayoutRegion& region, char* url, size_t size);
 }
 
 #endif
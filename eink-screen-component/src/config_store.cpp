@@ -0,0 +1,155 @@
+#include "config_store.h"
+#include "config_manager.h"
+#include "logging.h"
+#include <Preferences.h>
+
+namespace ConfigStore {
+
+// NVS namespace and layout version; bump the version when fields change
+static const char* NVS_NAMESPACE = "remote_cfg";
+constexpr uint8_t STORE_VERSION = 5;
+
+// Per-region keys: "r<index>_rect" (x, y, width, height, interval) and "r<index>_tpl"
+static void regionKey(char* key, size_t size, int index, const char* field) {
+    snprintf(key, size, "r%d_%s", index, field);
+}
+
+static void loadRegions(Preferences& prefs, RemoteConfig& config) {
+    config.regionCount = min((int)prefs.getUChar("regions", 0), MAX_REGIONS);
+    for (int i = 0; i < config.regionCount; i++) {
+        LayoutRegion& region = config.regions[i];
+        uint16_t rect[5] = {0, 0, 0, 0, 0};
+        char key[16];
+        regionKey(key, sizeof(key), i, "rect");
+        prefs.getBytes(key, rect, sizeof(rect));
+        region.x = rect[0];
+        region.y = rect[1];
+        region.width = rect[2];
+        region.height = rect[3];
+        region.intervalSec = rect[4];
+        regionKey(key, sizeof(key), i, "tpl");
+        region.templateName = prefs.getString(key, "");
+    }
+}
+
+// Per-overlay keys: "o<index>_rect" (x, y, width, height, font, align) and "o<index>_fmt"
+static void loadOverlays(Preferences& prefs, RemoteConfig& config) {
+    config.overlayCount = min((int)prefs.getUChar("overlays", 0), MAX_OVERLAYS);
+    for (int i = 0; i < config.overlayCount; i++) {
+        OverlaySlot& overlay = config.overlays[i];
+        uint16_t rect[6] = {0, 0, 0, 0, 12, 'l'};
+        char key[16];
+        snprintf(key, sizeof(key), "o%d_rect", i);
+        prefs.getBytes(key, rect, sizeof(rect));
+        overlay.x = rect[0];
+        overlay.y = rect[1];
+        overlay.width = rect[2];
+        overlay.height = rect[3];
+        overlay.font = rect[4];
+        overlay.align = (char)rect[5];
+        snprintf(key, sizeof(key), "o%d_fmt", i);
+        overlay.format = prefs.getString(key, "");
+    }
+}
+
+static void saveOverlays(Preferences& prefs, const RemoteConfig& config) {
+    prefs.putUChar("overlays", config.overlayCount);
+    for (int i = 0; i < config.overlayCount; i++) {
+        const OverlaySlot& overlay = config.overlays[i];
+        uint16_t rect[6] = {overlay.x, overlay.y, overlay.width, overlay.height, overlay.font, (uint16_t)overlay.align};
+        char key[16];
+        snprintf(key, sizeof(key), "o%d_rect", i);
+        prefs.putBytes(key, rect, sizeof(rect));
+        snprintf(key, sizeof(key), "o%d_fmt", i);
+        prefs.putString(key, overlay.format);
+    }
+}
+
+static void saveRegions(Preferences& prefs, const RemoteConfig& config) {
+    prefs.putUChar("regions", config.regionCount);
+    for (int i = 0; i < config.regionCount; i++) {
+        const LayoutRegion& region = config.regions[i];
+        uint16_t rect[5] = {region.x, region.y, region.width, region.height, region.intervalSec};
+        char key[16];
+        regionKey(key, sizeof(key), i, "rect");
+        prefs.putBytes(key, rect, sizeof(rect));
+        regionKey(key, sizeof(key), i, "tpl");
+        prefs.putString(key, region.templateName);
+    }
+}
+
+bool load(RemoteConfig& config) {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {
+        return false;
+    }
+
+    if (prefs.getUChar("version", 0) != STORE_VERSION) {
+        prefs.end();
+        return false;
+    }
+
+    // A plain http:// URL stored by older firmware does not override an https:// default
+    ConfigManager::setBaseUrl(config, prefs.getString("base_url", config.imageBaseUrl));
+    config.imagePath = prefs.getString("path", config.imagePath);
+    config.imageFormat = prefs.getString("format", config.imageFormat);
+    config.imageThreshold = prefs.getUShort("threshold", config.imageThreshold);
+    config.imageUrl = prefs.getString("url", config.imageUrl);
+    config.imageTemplate = prefs.getString("template", config.imageTemplate);
+    config.imageStream = prefs.getBool("stream", config.imageStream);
+    config.displayWidth = prefs.getUShort("width", config.displayWidth);
+    config.displayHeight = prefs.getUShort("height", config.displayHeight);
+    config.refreshIntervalSec = prefs.getUShort("refresh_sec", config.refreshIntervalSec);
+    config.partialRefreshCycles = prefs.getUShort("partial_cyc", config.partialRefreshCycles);
+    config.fullRefreshMinutes = prefs.getUShort("full_min", config.fullRefreshMinutes);
+    config.changesPath = prefs.getString("changes_path", config.changesPath);
+    config.changesTimeoutSec = prefs.getUShort("changes_sec", config.changesTimeoutSec);
+    loadRegions(prefs, config);
+    loadOverlays(prefs, config);
+    config.timeZone = prefs.getString("tz", config.timeZone);
+    config.ntpServer = prefs.getString("ntp", config.ntpServer);
+    config.etag = prefs.getString("etag", "");
+    config.revision++;
+    prefs.end();
+
+    LOG_INFO("Using cached config %s (%s%s)", config.etag.c_str(),
+             config.imageBaseUrl.c_str(), config.imagePath.c_str());
+    return true;
+}
+
+bool save(const RemoteConfig& config) {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        LOG_WARN("Cannot open NVS, config not cached");
+        return false;
+    }
+
+    // Invalidate first so a power cut mid-write never leaves a mixed config
+    prefs.putUChar("version", 0);
+    prefs.putString("base_url", config.imageBaseUrl);
+    prefs.putString("path", config.imagePath);
+    prefs.putString("format", config.imageFormat);
+    prefs.putUShort("threshold", config.imageThreshold);
+    prefs.putString("url", config.imageUrl);
+    prefs.putString("template", config.imageTemplate);
+    prefs.putBool("stream", config.imageStream);
+    prefs.putUShort("width", config.displayWidth);
+    prefs.putUShort("height", config.displayHeight);
+    prefs.putUShort("refresh_sec", config.refreshIntervalSec);
+    prefs.putUShort("partial_cyc", config.partialRefreshCycles);
+    prefs.putUShort("full_min", config.fullRefreshMinutes);
+    prefs.putString("changes_path", config.changesPath);
+    prefs.putUShort("changes_sec", config.changesTimeoutSec);
+    saveRegions(prefs, config);
+    saveOverlays(prefs, config);
+    prefs.putString("tz", config.timeZone);
+    prefs.putString("ntp", config.ntpServer);
+    prefs.putString("etag", config.etag);
+    prefs.putUChar("version", STORE_VERSION);
+    prefs.end();
+
+    LOG_INFO("Config cached in NVS");
+    return true;
+}
+
+}  // namespace ConfigStore
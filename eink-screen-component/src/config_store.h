@@ -0,0 +1,15 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include "config.h"
+
+namespace ConfigStore {
+    // Restore the last good remote config from NVS
+    // Returns false (config untouched) if nothing valid is stored
+    bool load(RemoteConfig& config);
+
+    // Persist config to NVS; call only when it changed to spare flash wear
+    bool save(const RemoteConfig& config);
+}
+
+#endif
@@ -1,5 +1,10 @@
 #include "display_driver.h"
+#include "logging.h"
 #include <SPI.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
 
 // Include fonts
 #include <Fonts/FreeMonoBold9pt7b.h>
@@ -7,24 +12,117 @@
 #include <Fonts/FreeMonoBold18pt7b.h>
 #include <Fonts/FreeMonoBold24pt7b.h>
 
-// Display instance with Waveshare ESP32 Driver Board pins
-static GxEPD2_BW<GxEPD2_750_GDEY075T7, MAX_HEIGHT(GxEPD2_750_GDEY075T7)> display(
-    GxEPD2_750_GDEY075T7(/*CS=*/15, /*DC=*/27, /*RST=*/26, /*BUSY=*/25));
+// Display instance for the build's panel, pins from config.h
+static GxEPD2_BW<DisplayDriver::Panel, MAX_HEIGHT(DisplayDriver::Panel)> display(
+    DisplayDriver::Panel(EPD_CS, EPD_DC, EPD_RST, EPD_BUSY));
 
 namespace DisplayDriver {
 
-void init() {
-    Serial.println("Initializing SPI...");
-    Serial.printf("Using SPI pins - SCK: %d, MISO: %d, MOSI: %d, SS: %d\n",
-                  SPI_SCK, SPI_MISO, SPI_MOSI, SPI_SS);
+constexpr int COMMAND_QUEUE_LENGTH = 16;
+constexpr uint32_t DISPLAY_TASK_STACK = 3072;
+constexpr UBaseType_t DISPLAY_TASK_PRIORITY = 1;
+constexpr BaseType_t DISPLAY_CORE = 0;
+
+// One refresh step for the display task
+struct Command {
+    enum Kind : uint8_t { REFRESH_FULL, REFRESH_FAST, REFRESH_WINDOW, WRITE_AGAIN } kind;
+    int16_t x, y, w, h;
+    const uint8_t* bitmap;
+};
+
+// Created with the first refresh and kept: a steady-state frame allocates nothing
+static QueueHandle_t commands = nullptr;
+static SemaphoreHandle_t commandDone = nullptr;  // Given after each command
+static bool taskStarted = false;
+static bool taskFailed = false;
+
+// Only the caller writes queued and only the display task writes completed
+static volatile uint32_t queued = 0;
+static volatile uint32_t completed = 0;
+
+// GxEPD2 polls BUSY with delay(), which blocks only this task
+static void runCommand(const Command& command) {
+    switch (command.kind) {
+        case Command::REFRESH_FULL: display.refresh(false); break;
+        case Command::REFRESH_FAST: display.refresh(true); break;
+        case Command::REFRESH_WINDOW: display.refresh(command.x, command.y, command.w, command.h); break;
+        case Command::WRITE_AGAIN:
+            display.epd2.writeImageAgain(command.bitmap, command.x, command.y, command.w, command.h);
+            break;
+    }
+}
+
+static void displayTask(void*) {
+    for (;;) {
+        Command command;
+        xQueueReceive(commands, &command, portMAX_DELAY);
+        runCommand(command);
+        completed = completed + 1;
+        xSemaphoreGive(commandDone);
+    }
+}
+
+static bool startTask() {
+    if (taskStarted || taskFailed) {
+        return taskStarted;
+    }
+
+    commands = xQueueCreate(COMMAND_QUEUE_LENGTH, sizeof(Command));
+    commandDone = xSemaphoreCreateBinary();
+    taskStarted = commands != nullptr && commandDone != nullptr &&
+                  xTaskCreatePinnedToCore(displayTask, "display", DISPLAY_TASK_STACK, nullptr,
+                                          DISPLAY_TASK_PRIORITY, nullptr, DISPLAY_CORE) == pdPASS;
+    if (!taskStarted) {
+        LOG_WARN("Display task unavailable, refreshing in the foreground");
+        if (commands != nullptr) vQueueDelete(commands);
+        if (commandDone != nullptr) vSemaphoreDelete(commandDone);
+        commands = nullptr;
+        commandDone = nullptr;
+        taskFailed = true;
+    }
+    return taskStarted;
+}
+
+// Queue a command; without the task it runs at once
+static void submit(const Command& command) {
+    if (!startTask()) {
+        runCommand(command);
+        return;
+    }
+    queued = queued + 1;
+    xQueueSend(commands, &command, portMAX_DELAY);
+}
+
+bool busy() {
+    return queued != completed;
+}
+
+void waitUntilIdle() {
+    // A give left over from an earlier command only costs one more check
+    while (busy()) {
+        xSemaphoreTake(commandDone, portMAX_DELAY);
+    }
+}
+
+void init(bool initial) {
+    waitUntilIdle();
+
+    LOG_DEBUG("Initializing SPI...");
+    LOG_DEBUG("Using SPI pins - SCK: %d, MISO: %d, MOSI: %d, SS: %d",
+              SPI_SCK, SPI_MISO, SPI_MOSI, SPI_SS);
     SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI, SPI_SS);
 
-    Serial.println("Initializing display...");
-    display.init(115200);
-    Serial.println("Display initialized");
+    LOG_DEBUG("Initializing display...");
+    display.init(115200, initial, 10, false);
+    LOG_DEBUG("Display initialized");
+
+    LOG_DEBUG("Display dimensions - Width: %d, Height: %d",
+              display.width(), display.height());
+}
 
-    Serial.printf("Display dimensions - Width: %d, Height: %d\n",
-                  display.width(), display.height());
+void hibernate() {
+    waitUntilIdle();
+    display.hibernate();
 }
 
 int16_t width() {
@@ -36,22 +134,27 @@ int16_t height() {
 }
 
 void setRotation(uint8_t rotation) {
+    waitUntilIdle();
     display.setRotation(rotation);
 }
 
 void setFullWindow() {
+    waitUntilIdle();
     display.setFullWindow();
 }
 
 void setPartialWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    waitUntilIdle();
     display.setPartialWindow(x, y, w, h);
 }
 
 void firstPage() {
+    waitUntilIdle();
     display.firstPage();
 }
 
 bool nextPage() {
+    waitUntilIdle();
     return display.nextPage();
 }
 
@@ -109,24 +212,121 @@ void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap,
     display.drawBitmap(x, y, bitmap, w, h, color);
 }
 
-void drawScaledBitmap(int16_t x, int16_t y, const uint8_t* bitmap,
-                      int16_t w, int16_t h, uint16_t color, uint8_t scale) {
+void writeImageForFullRefresh(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h) {
+    waitUntilIdle();
+    display.epd2.writeImageForFullRefresh(bitmap, x, y, w, h);
+}
+
+void writeImage(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h) {
+    waitUntilIdle();
+    display.writeImage(bitmap, x, y, w, h);
+}
+
+void writeImageAgain(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h) {
+    submit({Command::WRITE_AGAIN, x, y, w, h, bitmap});
+}
+
+void refresh(bool partialUpdateMode) {
+    submit({partialUpdateMode ? Command::REFRESH_FAST : Command::REFRESH_FULL, 0, 0, 0, 0, nullptr});
+}
+
+void refresh(int16_t x, int16_t y, int16_t w, int16_t h) {
+    submit({Command::REFRESH_WINDOW, x, y, w, h, nullptr});
+}
+
+// True if two source rows have the same pixels (bits past w ignored)
+static bool rowsEqual(const uint8_t* a, const uint8_t* b, int16_t w) {
+    int16_t fullBytes = w / 8;
+    for (int16_t i = 0; i < fullBytes; i++) {
+        if (pgm_read_byte(a + i) != pgm_read_byte(b + i)) {
+            return false;
+        }
+    }
+    if (w % 8 == 0) {
+        return true;
+    }
+    uint8_t mask = 0xFF << (8 - w % 8);
+    return (pgm_read_byte(a + fullBytes) & mask) == (pgm_read_byte(b + fullBytes) & mask);
+}
+
+// Fill every horizontal run of set pixels in one source row as a single
+// rectangle of the given height; whole 0x00/0xFF bytes are skipped/extended
+// without looking at individual bits
+static inline __attribute__((always_inline)) void blitRow(int16_t x, int16_t y, const uint8_t* row,
+                                                          int16_t w, int16_t heightPx, uint16_t color,
+                                                          uint8_t scale) {
     int16_t byteWidth = (w + 7) / 8;
+    int16_t runStart = -1;
+
+    for (int16_t b = 0; b < byteWidth; b++) {
+        uint8_t bits = pgm_read_byte(row + b);
+        int16_t base = b * 8;
+
+        if (bits == 0xFF && base + 8 <= w) {
+            if (runStart < 0) {
+                runStart = base;
+            }
+            continue;
+        }
+
+        if (bits == 0x00) {
+            if (runStart >= 0) {
+                display.fillRect(x + runStart * scale, y, (base - runStart) * scale, heightPx, color);
+                runStart = -1;
+            }
+            continue;
+        }
 
-    for (int16_t row = 0; row < h; row++) {
-        for (int16_t col = 0; col < w; col++) {
-            uint8_t byte = pgm_read_byte(bitmap + row * byteWidth + col / 8);
-            bool pixelSet = byte & (0x80 >> (col % 8));
-
-            if (pixelSet) {
-                if (scale == 1) {
-                    display.drawPixel(x + col, y + row, color);
-                } else {
-                    display.fillRect(x + col * scale, y + row * scale, scale, scale, color);
-                }
+        for (int16_t bit = 0; bit < 8 && base + bit < w; bit++) {
+            bool pixelSet = bits & (0x80 >> bit);
+            if (pixelSet && runStart < 0) {
+                runStart = base + bit;
+            } else if (!pixelSet && runStart >= 0) {
+                display.fillRect(x + runStart * scale, y, (base + bit - runStart) * scale, heightPx, color);
+                runStart = -1;
             }
         }
     }
+
+    if (runStart >= 0) {
+        display.fillRect(x + runStart * scale, y, (w - runStart) * scale, heightPx, color);
+    }
+}
+
+// Identical consecutive rows (common in icons) are merged into one taller run
+static inline __attribute__((always_inline)) void blitBitmap(int16_t x, int16_t y, const uint8_t* bitmap,
+                                                             int16_t w, int16_t h, uint16_t color,
+                                                             uint8_t scale) {
+    int16_t byteWidth = (w + 7) / 8;
+    int16_t row = 0;
+
+    while (row < h) {
+        const uint8_t* src = bitmap + row * byteWidth;
+        int16_t rows = 1;
+        while (row + rows < h && rowsEqual(src, src + rows * byteWidth, w)) {
+            rows++;
+        }
+
+        blitRow(x, y + row * scale, src, w, rows * scale, color, scale);
+        row += rows;
+    }
+}
+
+// Compile-time scale so the multiplies fold into shifts/constants
+template <uint8_t SCALE>
+static void blitScaled(int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, uint16_t color) {
+    blitBitmap(x, y, bitmap, w, h, color, SCALE);
+}
+
+void drawScaledBitmap(int16_t x, int16_t y, const uint8_t* bitmap,
+                      int16_t w, int16_t h, uint16_t color, uint8_t scale) {
+    switch (scale) {
+        case 1: blitScaled<1>(x, y, bitmap, w, h, color); break;
+        case 2: blitScaled<2>(x, y, bitmap, w, h, color); break;
+        case 3: blitScaled<3>(x, y, bitmap, w, h, color); break;
+        case 4: blitScaled<4>(x, y, bitmap, w, h, color); break;
+        default: blitBitmap(x, y, bitmap, w, h, color, scale); break;
+    }
 }
 
 }  // namespace DisplayDriver
@@ -5,10 +5,24 @@
 #include "config.h"
 
 namespace DisplayDriver {
+    // Panel selected at build time (EPD_PANEL in config.h); frame and band
+    // sizes derive from it, so no buffer can disagree with the panel
+    using Panel = EPD_PANEL;
+    constexpr int16_t WIDTH = Panel::WIDTH;
+    constexpr int16_t HEIGHT = Panel::HEIGHT;
+    constexpr size_t BYTES_PER_ROW = WIDTH / 8;
+    constexpr size_t FRAME_BYTES = BYTES_PER_ROW * HEIGHT;
+    static_assert(WIDTH % 8 == 0, "Controller RAM rows must be whole bytes");
+
     // Initialize SPI and display hardware
-    void init();
+    // initial = false after a deep sleep wake: the panel still shows the last
+    // frame, so the driver skips its initial clearing refresh
+    void init(bool initial = true);
+
+    // Power down the panel controller until the next init()
+    void hibernate();
 
-    // Get display dimensions
+    // Get display dimensions after rotation (WIDTH x HEIGHT at rotation 0)
     int16_t width();
     int16_t height();
 
@@ -58,6 +72,36 @@ namespace DisplayDriver {
     void drawBitmap(int16_t x, int16_t y, const uint8_t* bitmap,
                     int16_t w, int16_t h, uint16_t color);
 
+    // Write rows straight into controller RAM for the next full refresh
+    // Bypasses the framebuffer; bits use panel polarity (1 = white)
+    void writeImageForFullRefresh(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h);
+
+    // Write rows into controller RAM as the new image for a differential refresh
+    void writeImage(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h);
+
+    // Refreshes and the previous-image writes after them run on a display task,
+    // so the caller can fetch, report or shut WiFi down while the panel runs its
+    // waveform (seconds on a full refresh); they return once queued
+    // Every other call that touches the controller waits for the queue first
+
+    // Write rows again after a differential refresh so the controller's
+    // previous-image RAM matches what is now on the panel
+    // bitmap is read when the command runs: leave it alone until the next
+    // driver call (or waitUntilIdle()) returns
+    void writeImageAgain(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h);
+
+    // Refresh the panel from controller RAM
+    void refresh(bool partialUpdateMode = false);
+
+    // Refresh only a window of the panel from controller RAM (fast partial waveform)
+    void refresh(int16_t x, int16_t y, int16_t w, int16_t h);
+
+    // True while queued refreshes are still running
+    bool busy();
+
+    // Block until the panel is idle and the queue is empty
+    void waitUntilIdle();
+
     // Draw scaled bitmap from PROGMEM
     void drawScaledBitmap(int16_t x, int16_t y, const uint8_t* bitmap,
                           int16_t w, int16_t h, uint16_t color, uint8_t scale);
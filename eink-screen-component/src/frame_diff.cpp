@@ -0,0 +1,222 @@
+#include "frame_diff.h"
+#include "logging.h"
+#include "display_driver.h"
+
+namespace FrameDiff {
+
+// More horizontal runs than this are collapsed to one bounding box
+constexpr int MAX_CANDIDATES = 48;
+
+// Fixed by the build's panel, so row and tile loops run to constant bounds
+constexpr uint16_t frameWidth = DisplayDriver::WIDTH;
+constexpr uint16_t frameHeight = DisplayDriver::HEIGHT;
+constexpr uint16_t bytesPerRow = DisplayDriver::BYTES_PER_ROW;
+constexpr uint16_t tilesX = (frameWidth + TILE_SIZE - 1) / TILE_SIZE;
+constexpr uint16_t tilesY = (frameHeight + TILE_SIZE - 1) / TILE_SIZE;
+constexpr size_t DIRTY_BYTES = (tilesX * tilesY + 7) / 8;
+
+static uint8_t* previous = nullptr;      // Last frame sent to the panel
+static uint8_t dirtyTiles[DIRTY_BYTES];  // One bit per tile
+static bool previousValid = false;
+
+static void markTile(int tx, int ty) {
+    int bit = ty * tilesX + tx;
+    dirtyTiles[bit >> 3] |= (1 << (bit & 7));
+}
+
+static bool tileDirty(int tx, int ty) {
+    int bit = ty * tilesX + tx;
+    return dirtyTiles[bit >> 3] & (1 << (bit & 7));
+}
+
+static Rect unite(const Rect& a, const Rect& b) {
+    uint16_t x0 = min(a.x, b.x);
+    uint16_t y0 = min(a.y, b.y);
+    uint16_t x1 = max(a.x + a.w, b.x + b.w);
+    uint16_t y1 = max(a.y + a.h, b.y + b.h);
+    return {x0, y0, (uint16_t)(x1 - x0), (uint16_t)(y1 - y0)};
+}
+
+static int32_t area(const Rect& r) {
+    return (int32_t)r.w * r.h;
+}
+
+bool begin() {
+    constexpr size_t frameBytes = DisplayDriver::FRAME_BYTES;
+    if (previous == nullptr) {
+        previous = (uint8_t*)(psramFound() ? ps_malloc(frameBytes) : malloc(frameBytes));
+    }
+
+    if (previous == nullptr) {
+        LOG_WARN("Frame diff disabled: cannot allocate %u bytes", (unsigned)frameBytes);
+        return false;
+    }
+
+    LOG_INFO("Frame diff enabled: %dx%d tiles of %dpx (%s)",
+             tilesX, tilesY, TILE_SIZE, psramFound() ? "PSRAM" : "heap");
+    previousValid = false;
+    return true;
+}
+
+bool enabled() {
+    return previous != nullptr;
+}
+
+bool hasPrevious() {
+    return previousValid;
+}
+
+void invalidate() {
+    previousValid = false;
+}
+
+void beginFrame() {
+    if (!enabled()) {
+        return;
+    }
+    memset(dirtyTiles, 0, sizeof(dirtyTiles));
+}
+
+void compareBand(const uint8_t* rows, int16_t y, int16_t h) {
+    if (!enabled() || y < 0 || y + h > frameHeight) {
+        return;
+    }
+
+    constexpr int TILE_BYTES = TILE_SIZE / 8;
+
+    for (int16_t row = 0; row < h; row++) {
+        const uint8_t* src = rows + (size_t)row * bytesPerRow;
+        uint8_t* dst = previous + (size_t)(y + row) * bytesPerRow;
+
+        // Most rows on a dashboard are unchanged, check the whole row first
+        if (memcmp(src, dst, bytesPerRow) == 0) {
+            continue;
+        }
+
+        int ty = (y + row) / TILE_SIZE;
+        for (int tx = 0; tx < tilesX; tx++) {
+            int start = tx * TILE_BYTES;
+            int len = min(TILE_BYTES, bytesPerRow - start);
+            if (memcmp(src + start, dst + start, len) != 0) {
+                markTile(tx, ty);
+            }
+        }
+        memcpy(dst, src, bytesPerRow);
+    }
+}
+
+void patch(const uint8_t* rows, int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (!enabled()) {
+        return;
+    }
+    int rowBytes = w / 8;
+    for (int row = 0; row < h && y + row < frameHeight; row++) {
+        memcpy(&previous[(y + row) * bytesPerRow + x / 8], &rows[row * rowBytes], rowBytes);
+    }
+}
+
+void commit() {
+    previousValid = enabled();
+}
+
+int dirtyRects(Rect* out, int maxRects) {
+    if (!enabled() || maxRects <= 0) {
+        return 0;
+    }
+
+    // Horizontal runs of changed tiles are the starting candidates
+    Rect candidates[MAX_CANDIDATES];
+    int count = 0;
+    bool overflow = false;
+    Rect bounds = {0, 0, 0, 0};
+
+    for (int ty = 0; ty < tilesY; ty++) {
+        int tx = 0;
+        while (tx < tilesX) {
+            if (!tileDirty(tx, ty)) {
+                tx++;
+                continue;
+            }
+            int runStart = tx;
+            while (tx < tilesX && tileDirty(tx, ty)) {
+                tx++;
+            }
+
+            Rect run = {(uint16_t)(runStart * TILE_SIZE), (uint16_t)(ty * TILE_SIZE),
+                        (uint16_t)((tx - runStart) * TILE_SIZE), (uint16_t)TILE_SIZE};
+            bounds = (count == 0 && !overflow) ? run : unite(bounds, run);
+
+            if (count < MAX_CANDIDATES) {
+                candidates[count++] = run;
+            } else {
+                overflow = true;
+            }
+        }
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    if (overflow) {
+        count = 1;
+        candidates[0] = bounds;
+    }
+
+    // Greedily merge the pair that wastes the least area; merges that cost
+    // nothing (stacked runs) always happen, others only to get under maxRects
+    while (count > 1) {
+        int bestA = 0;
+        int bestB = 1;
+        int32_t bestWaste = INT32_MAX;
+
+        for (int a = 0; a < count; a++) {
+            for (int b = a + 1; b < count; b++) {
+                int32_t waste = area(unite(candidates[a], candidates[b])) - area(candidates[a]) - area(candidates[b]);
+                if (waste < bestWaste) {
+                    bestWaste = waste;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+
+        if (bestWaste > 0 && count <= maxRects) {
+            break;
+        }
+
+        candidates[bestA] = unite(candidates[bestA], candidates[bestB]);
+        candidates[bestB] = candidates[--count];
+    }
+
+    for (int i = 0; i < count; i++) {
+        // Edge tiles may extend past the panel
+        Rect r = candidates[i];
+        r.w = min(r.w, (uint16_t)(frameWidth - r.x));
+        r.h = min(r.h, (uint16_t)(frameHeight - r.y));
+        out[i] = r;
+    }
+    return count;
+}
+
+int dirtyPercent() {
+    if (!enabled()) {
+        return 100;
+    }
+
+    int dirty = 0;
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            if (tileDirty(tx, ty)) {
+                dirty++;
+            }
+        }
+    }
+    return dirty * 100 / (tilesX * tilesY);
+}
+
+const uint8_t* frame() {
+    return previous;
+}
+
+}  // namespace FrameDiff
@@ -0,0 +1,58 @@
+#ifndef FRAME_DIFF_H
+#define FRAME_DIFF_H
+
+#include <Arduino.h>
+
+namespace FrameDiff {
+    // Tile edge in pixels; changes are tracked per tile (multiple of 8 keeps windows byte-aligned)
+    constexpr int TILE_SIZE = 16;
+
+    // Upper bound on partial windows refreshed per frame
+    constexpr int MAX_RECTS = 4;
+
+    // Above this share of changed pixels one full-screen pass beats per-region windows
+    constexpr int FULL_REFRESH_PERCENT = 50;
+
+    struct Rect {
+        uint16_t x, y, w, h;
+    };
+
+    // Allocate the previous-frame copy for the build's panel (PSRAM when available)
+    // Returns false if there is not enough memory; diffing then stays disabled
+    bool begin();
+
+    // True if the previous-frame buffer exists
+    bool enabled();
+
+    // True if the stored frame matches what is on the panel
+    bool hasPrevious();
+
+    // Forget the stored frame (panel was drawn over by something else)
+    void invalidate();
+
+    // Start comparing a new frame
+    void beginFrame();
+
+    // Compare full-width rows against the stored frame, mark changed tiles
+    // and store the rows as the new frame
+    void compareBand(const uint8_t* rows, int16_t y, int16_t h);
+
+    // Copy a byte-aligned rectangle (rows of w / 8 bytes) into the stored frame,
+    // e.g. a layout region refreshed on its own; it does not mark tiles dirty
+    void patch(const uint8_t* rows, int16_t x, int16_t y, int16_t w, int16_t h);
+
+    // Mark the stored frame as matching the panel after a successful refresh
+    void commit();
+
+    // Merge changed tiles into at most maxRects rectangles
+    // Returns the number of rectangles written to out
+    int dirtyRects(Rect* out, int maxRects);
+
+    // Changed pixels (tile granularity) as a percentage of the frame
+    int dirtyPercent();
+
+    // Stored frame, full width, top-down, panel polarity
+    const uint8_t* frame();
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include "frame_store.h"
+#include "logging.h"
+#include "app_state.h"
+#include <LittleFS.h>
+
+namespace FrameStore {
+
+// Written to a temporary file and renamed, so a power cut never leaves a torn frame
+static const char* FRAME_PATH = "/frame.bin";
+static const char* TEMP_PATH = "/frame.tmp";
+constexpr uint32_t FRAME_MAGIC = 0x31464945;  // "EIF1"
+
+struct Header {
+    uint32_t magic;
+    uint16_t width;
+    uint16_t height;
+    char etag[ETAG_MAX_LEN];
+};
+
+static bool mounted = false;
+static File writer;
+static File reader;
+static size_t expectedBytes = 0;
+static size_t writtenBytes = 0;
+
+bool begin() {
+    mounted = LittleFS.begin(true);
+    if (!mounted) {
+        LOG_WARN("LittleFS unavailable, frame cache disabled");
+    }
+    return mounted;
+}
+
+bool beginWrite(uint16_t width, uint16_t height) {
+    discard();
+    if (!mounted) {
+        return false;
+    }
+
+    writer = LittleFS.open(TEMP_PATH, FILE_WRITE);
+    if (!writer) {
+        return false;
+    }
+
+    // ETag is filled in by commit() once the frame is complete
+    Header header = {FRAME_MAGIC, width, height, {0}};
+    writer.write((const uint8_t*)&header, sizeof(header));
+    expectedBytes = (size_t)(width + 7) / 8 * height;
+    writtenBytes = 0;
+    return true;
+}
+
+void write(const uint8_t* rows, size_t bytes) {
+    if (!writer) {
+        return;
+    }
+    if (writer.write(rows, bytes) != bytes) {
+        LOG_ERROR("Frame cache write failed");
+        discard();
+        return;
+    }
+    writtenBytes += bytes;
+}
+
+bool commit(const char* etag) {
+    if (!writer) {
+        return false;
+    }
+    if (writtenBytes != expectedBytes) {
+        discard();
+        return false;
+    }
+
+    char tag[ETAG_MAX_LEN] = {0};
+    strncpy(tag, etag, sizeof(tag) - 1);
+    writer.seek(offsetof(Header, etag));
+    writer.write((const uint8_t*)tag, sizeof(tag));
+    writer.close();
+
+    LittleFS.remove(FRAME_PATH);
+    if (!LittleFS.rename(TEMP_PATH, FRAME_PATH)) {
+        LOG_ERROR("Frame cache rename failed");
+        return false;
+    }
+    LOG_INFO("Frame cached in flash (%u bytes)", (unsigned)writtenBytes);
+    return true;
+}
+
+void discard() {
+    if (writer) {
+        writer.close();
+        LittleFS.remove(TEMP_PATH);
+    }
+}
+
+bool open(uint16_t width, uint16_t height, char* etag, size_t etagSize) {
+    close();
+    if (!mounted || !LittleFS.exists(FRAME_PATH)) {
+        return false;
+    }
+
+    reader = LittleFS.open(FRAME_PATH, FILE_READ);
+    Header header;
+    size_t frameBytes = (size_t)(width + 7) / 8 * height;
+    if (!reader || reader.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != FRAME_MAGIC || header.width != width || header.height != height ||
+        reader.size() != sizeof(header) + frameBytes) {
+        close();
+        return false;
+    }
+
+    header.etag[sizeof(header.etag) - 1] = '\0';
+    strncpy(etag, header.etag, etagSize - 1);
+    etag[etagSize - 1] = '\0';
+    return true;
+}
+
+size_t read(uint8_t* rows, size_t bytes) {
+    return reader ? reader.read(rows, bytes) : 0;
+}
+
+void close() {
+    if (reader) {
+        reader.close();
+    }
+}
+
+}  // namespace FrameStore
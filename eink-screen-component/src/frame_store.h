@@ -0,0 +1,36 @@
+#ifndef FRAME_STORE_H
+#define FRAME_STORE_H
+
+#include <Arduino.h>
+
+// Last good frame in LittleFS, so the panel has content before the network
+// is up and while the server cannot be reached
+namespace FrameStore {
+    // Mount the filesystem (formatted on first use)
+    // Returns false if flash is unavailable; the store then stays disabled
+    bool begin();
+
+    // Start recording a frame of width x height; rows follow top-down via write()
+    bool beginWrite(uint16_t width, uint16_t height);
+
+    // Append rows of the frame being recorded
+    void write(const uint8_t* rows, size_t bytes);
+
+    // Frame is complete: replace the stored one (etag may be empty)
+    bool commit(const char* etag);
+
+    // Drop a partly recorded frame, the stored one stays
+    void discard();
+
+    // Open the stored frame for reading if it has this size
+    // Copies its ETag into etag (etagSize bytes including the terminator)
+    bool open(uint16_t width, uint16_t height, char* etag, size_t etagSize);
+
+    // Read the next rows of the opened frame, returns the bytes read
+    size_t read(uint8_t* rows, size_t bytes);
+
+    // Finish reading
+    void close();
+}
+
+#endif
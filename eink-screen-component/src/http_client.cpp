@@ -1,25 +1,144 @@
 #include "http_client.h"
+#include "logging.h"
+#include "tls_client.h"
 #include <WiFi.h>
 
-bool HttpConnection::begin(const String& url, int timeout) {
+// Response headers are only kept if requested before the request is sent
+static const char* HEADER_KEYS[] = {"ETag"};
+constexpr size_t HEADER_KEY_COUNT = sizeof(HEADER_KEYS) / sizeof(HEADER_KEYS[0]);
+
+// "http://host:port/path" -> "host:port", false if it does not fit
+static bool hostOf(const char* url, char* host, size_t size) {
+    const char* start = strstr(url, "://");
+    start = start == nullptr ? url : start + 3;
+    const char* end = strchr(start, '/');
+    size_t length = end == nullptr ? strlen(start) : (size_t)(end - start);
+    if (length >= size) {
+        return false;
+    }
+    memcpy(host, start, length);
+    host[length] = '\0';
+    return true;
+}
+
+bool HttpConnection::begin(const char* requestUrl, int timeout) {
     if (WiFi.status() != WL_CONNECTED) {
+        close();
         return false;
     }
 
-    if (!httpClient.begin(wifiClient, url)) {
+    char host[HOST_MAX_LEN];
+    if (strlen(requestUrl) >= sizeof(url) || !hostOf(requestUrl, host, sizeof(host))) {
+        LOG_ERROR("URL too long: %.64s...", requestUrl);
+        return false;
+    }
+
+    // A socket to another server, or of the other scheme, cannot be reused
+    bool secure = strncmp(requestUrl, "https://", 8) == 0;
+    if (strcmp(host, socketHost) != 0 || secure != socketSecure) {
+        close();
+    }
+
+    if (secure && tlsClient == nullptr) {
+        tlsClient = new TlsClient();
+        tlsClient->setSessionCache(tlsSession);
+    }
+    socketSecure = secure;
+
+    if (!httpClient.begin(client(), requestUrl)) {
         return false;
     }
 
+    if (requestUrl != url) {
+        strcpy(url, requestUrl);
+    }
+    timeoutMs = timeout;
+    ifNoneMatch[0] = '\0';
+    etag[0] = '\0';
+    strcpy(socketHost, host);
+    httpClient.setReuse(true);
     httpClient.setTimeout(timeout);
+    httpClient.collectHeaders(HEADER_KEYS, HEADER_KEY_COUNT);
+    return true;
+}
+
+void HttpConnection::setIfNoneMatch(const char* value) {
+    snprintf(ifNoneMatch, sizeof(ifNoneMatch), "%s", value);
+    httpClient.addHeader("If-None-Match", value);
+}
+
+// url still holds the request; begin() keeps it in place
+bool HttpConnection::reopen() {
+    char retryEtag[ETAG_MAX_LEN];
+    strcpy(retryEtag, ifNoneMatch);
+    close();
+    if (!begin(url, timeoutMs)) {
+        return false;
+    }
+    if (retryEtag[0] != '\0') {
+        setIfNoneMatch(retryEtag);
+    }
     return true;
 }
 
+WiFiClient& HttpConnection::client() {
+    return socketSecure ? *tlsClient : wifiClient;
+}
+
+// The server may have closed an idle keep-alive socket; only then it is worth
+// retrying, a fresh connection that failed would just fail again
 int HttpConnection::get() {
-    return httpClient.GET();
+    bool reused = client().connected();
+    int code = httpClient.GET();
+
+    if (code < 0 && reused) {
+        LOG_WARN("Kept-alive connection failed (%d), reconnecting", code);
+        if (!reopen()) {
+            return code;
+        }
+        code = httpClient.GET();
+    }
+
+    return code;
+}
+
+int HttpConnection::post(const char* contentType, const uint8_t* body, size_t length) {
+    bool reused = client().connected();
+    httpClient.addHeader("Content-Type", contentType);
+    int code = httpClient.POST((uint8_t*)body, length);
+
+    if (code < 0 && reused) {
+        LOG_WARN("Kept-alive connection failed (%d), reconnecting", code);
+        if (!reopen()) {
+            return code;
+        }
+        httpClient.addHeader("Content-Type", contentType);
+        code = httpClient.POST((uint8_t*)body, length);
+    }
+
+    return code;
+}
+
+const char* HttpConnection::getETag() {
+    const String& value = httpClient.header("ETag");
+    if (value.length() < sizeof(etag)) {
+        strcpy(etag, value.c_str());
+    } else {
+        etag[0] = '\0';
+    }
+    return etag;
 }
 
-String HttpConnection::getResponseString() {
-    return httpClient.getString();
+void HttpConnection::discardBody() {
+    WiFiClient* stream = httpClient.getStreamPtr();
+    uint8_t scratch[64];
+    for (int remaining = httpClient.getSize(); remaining > 0 && stream != nullptr;) {
+        size_t bytesRead = stream->readBytes(scratch, min((size_t)remaining, sizeof(scratch)));
+        if (bytesRead == 0) {
+            break;
+        }
+        remaining -= bytesRead;
+    }
 }
 
 int HttpConnection::getResponseSize() {
@@ -33,3 +152,12 @@ WiFiClient* HttpConnection::getStream() {
 void HttpConnection::end() {
     httpClient.end();
 }
+
+void HttpConnection::close() {
+    httpClient.end();
+    wifiClient.stop();
+    if (tlsClient != nullptr) {
+        tlsClient->stop();
+    }
+    socketHost[0] = '\0';
+}
@@ -4,19 +4,67 @@
 #include <HTTPClient.h>
 #include <WiFiClient.h>
 
-// Manages HTTP connection lifecycle
+// Fixed capacities, so requests allocate nothing of their own
+constexpr size_t URL_MAX_LEN = 512;
+constexpr size_t HOST_MAX_LEN = 64;
+constexpr int ETAG_MAX_LEN = 48;  // Longer ETags are treated as absent
+constexpr size_t TLS_SESSION_MAX_LEN = 2048;  // Serialized mbedTLS session incl. ticket and peer certificate
+
+class TlsClient;
+
+// TLS session of the last handshake, kept in RTC memory so the first request
+// after a deep sleep wake resumes it instead of a full handshake
+struct TlsSession {
+    char host[HOST_MAX_LEN];  // Server the session belongs to
+    uint16_t length;          // Bytes of data in use, 0 if none
+    uint8_t data[TLS_SESSION_MAX_LEN];
+};
+
+// Long-lived HTTP client shared by config and image requests
+// Keeps the TCP connection open between requests to the same host
+// (HTTP/1.1 keep-alive) and reconnects when the server has dropped it
+// https:// URLs run over TlsClient, see TLS_PINS in config.h
 struct HttpConnection {
     WiFiClient wifiClient;
+    TlsClient* tlsClient = nullptr;        // Created for the first https:// URL and kept
+    TlsSession* tlsSession = nullptr;      // Resumption cache, may be null
     HTTPClient httpClient;
+    char url[URL_MAX_LEN] = "";            // Current request, kept to resend it on a stale socket
+    int timeoutMs = 10000;
+    char ifNoneMatch[ETAG_MAX_LEN] = "";
+    char socketHost[HOST_MAX_LEN] = "";    // host:port the open socket belongs to, empty if none
+    bool socketSecure = false;             // The open socket (or the next one) is TLS
+    char etag[ETAG_MAX_LEN] = "";          // See getETag()
+
+    // Prepare a request to URL with optional timeout (default 10s)
+    // Reuses the open socket when the host matches
+    // Fails for URLs longer than URL_MAX_LEN
+    bool begin(const char* url, int timeout = 10000);
 
-    // Initialize connection to URL with optional timeout (default 10s)
-    bool begin(const String& url, int timeout = 10000);
+    // Send If-None-Match so the server can answer 304 for an unchanged resource
+    // Call after begin() and before get()
+    void setIfNoneMatch(const char* etag);
+
+    // Socket of the current request: wifiClient, or tlsClient for https://
+    WiFiClient& client();
 
     // Perform GET request, returns HTTP status code
+    // A stale kept-alive socket is replaced and the request sent once more
     int get();
 
-    // Get response body as string
-    String getResponseString();
+    // Perform POST request with the given body, returns HTTP status code
+    // Retries a stale kept-alive socket like get()
+    int post(const char* contentType, const uint8_t* body, size_t length);
+
+    // Replace a stale socket and prepare the current request again
+    bool reopen();
+
+    // ETag of the last response, empty if the server sent none or it is
+    // longer than ETAG_MAX_LEN; valid until the next request
+    const char* getETag();
+
+    // Read and drop the response body so the socket can be reused
+    void discardBody();
 
     // Get response content length
     int getResponseSize();
@@ -24,8 +72,12 @@ struct HttpConnection {
     // Get stream pointer for chunked reading
     WiFiClient* getStream();
 
-    // Clean up connection
+    // Finish the request; the socket stays open for the next one
+    // The response body must have been read completely
     void end();
+
+    // Finish the request and drop the socket (body not fully read, errors)
+    void close();
 };
 
 #endif
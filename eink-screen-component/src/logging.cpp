@@ -0,0 +1,168 @@
+#include "logging.h"
+#include <stdarg.h>
+
+#if LOG_BUFFER_ENABLED
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#endif
+
+namespace Log {
+
+#if LOG_BUFFER_ENABLED
+constexpr uint32_t LOG_TASK_STACK = 2048;
+constexpr UBaseType_t LOG_TASK_PRIORITY = 0;  // Idle priority: the console waits for everything else
+constexpr BaseType_t LOG_CORE = 0;
+constexpr size_t DRAIN_CHUNK = 64;
+constexpr unsigned long FLUSH_TIMEOUT_MS = 1000;
+
+static char ring[LOG_BUFFER_SIZE];
+
+// Running byte counts; ring offsets are taken modulo LOG_BUFFER_SIZE
+// Bytes between tail and head are still to be written to Serial; writers
+// drop lines rather than overwrite them. Drained bytes stay readable for
+// takeRecent() until new lines reuse their space
+static volatile uint32_t head = 0;
+static volatile uint32_t tail = 0;
+static uint32_t reported = 0;
+static uint32_t dropped = 0;
+
+static SemaphoreHandle_t lock = nullptr;     // Guards the ring and its counters
+static SemaphoreHandle_t pending = nullptr;  // Given after each queued line
+static bool taskStarted = false;
+static bool taskFailed = false;
+
+static void copyOut(uint32_t from, char* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = ring[(from + i) % LOG_BUFFER_SIZE];
+    }
+}
+
+static void drainTask(void*) {
+    for (;;) {
+        xSemaphoreTake(pending, portMAX_DELAY);
+        for (;;) {
+            char chunk[DRAIN_CHUNK];
+            xSemaphoreTake(lock, portMAX_DELAY);
+            size_t count = min((size_t)(head - tail), sizeof(chunk));
+            copyOut(tail, chunk, count);
+            // Reported once the lines queued before the drops are out
+            uint32_t lost = count == 0 ? dropped : 0;
+            dropped -= lost;
+            xSemaphoreGive(lock);
+
+            if (count == 0) {
+                if (lost > 0) {
+                    Serial.printf("[%u log lines dropped]\n", (unsigned)lost);
+                }
+                break;
+            }
+            Serial.write((const uint8_t*)chunk, count);
+
+            // Advanced only once written, so flush() also waits for this chunk
+            xSemaphoreTake(lock, portMAX_DELAY);
+            tail = tail + count;
+            xSemaphoreGive(lock);
+        }
+    }
+}
+
+static bool startTask() {
+    if (taskStarted || taskFailed) {
+        return taskStarted;
+    }
+
+    lock = xSemaphoreCreateMutex();
+    pending = xSemaphoreCreateBinary();
+    taskStarted = lock != nullptr && pending != nullptr &&
+                  xTaskCreatePinnedToCore(drainTask, "log", LOG_TASK_STACK, nullptr,
+                                          LOG_TASK_PRIORITY, nullptr, LOG_CORE) == pdPASS;
+    if (!taskStarted) {
+        Serial.println("Log task unavailable, logging straight to Serial");
+        if (lock != nullptr) vSemaphoreDelete(lock);
+        if (pending != nullptr) vSemaphoreDelete(pending);
+        lock = nullptr;
+        pending = nullptr;
+        taskFailed = true;
+    }
+    return taskStarted;
+}
+
+static void push(const char* line, size_t length) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (head + length - tail > LOG_BUFFER_SIZE) {
+        dropped++;
+    } else {
+        for (size_t i = 0; i < length; i++) {
+            ring[(head + i) % LOG_BUFFER_SIZE] = line[i];
+        }
+        head = head + length;
+    }
+    xSemaphoreGive(lock);
+    xSemaphoreGive(pending);
+}
+#endif
+
+void write(const char* format, ...) {
+    char line[LINE_MAX_LEN];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+    if (length < 0) {
+        return;
+    }
+    length = min(length, (int)sizeof(line) - 2);
+    line[length++] = '\n';
+
+#if LOG_BUFFER_ENABLED
+    if (startTask()) {
+        push(line, length);
+        return;
+    }
+#endif
+    Serial.write((const uint8_t*)line, length);
+}
+
+void flush() {
+#if LOG_BUFFER_ENABLED
+    unsigned long startMs = millis();
+    while (taskStarted && tail != head && millis() - startMs < FLUSH_TIMEOUT_MS) {
+        delay(1);
+    }
+#endif
+    Serial.flush();
+}
+
+size_t takeRecent(char* out, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    size_t length = 0;
+
+#if LOG_BUFFER_ENABLED
+    if (taskStarted) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        uint32_t written = head;
+        uint32_t available = min(written - reported, min(written, (uint32_t)LOG_BUFFER_SIZE));
+        length = min((size_t)available, size - 1);
+        copyOut(written - length, out, length);
+        bool cut = length < written - reported;
+        reported = written;
+        xSemaphoreGive(lock);
+
+        // Start on a whole line when older text did not fit
+        if (cut) {
+            char* newline = (char*)memchr(out, '\n', length);
+            size_t skip = newline != nullptr ? newline + 1 - out : length;
+            memmove(out, out + skip, length - skip);
+            length -= skip;
+        }
+    }
+#endif
+
+    out[length] = '\0';
+    return length;
+}
+
+}  // namespace Log
@@ -0,0 +1,54 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Leveled logging: one line per call, printf format without the trailing newline
+// Lines above LOG_LEVEL (config.h) compile to nothing: their arguments are
+// still type-checked but never evaluated, and their strings are not linked in
+// With LOG_BUFFER_ENABLED a line is copied into a RAM ring buffer and a
+// low-priority task writes it to Serial, so callers never wait for the UART
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Log::write(__VA_ARGS__)
+#else
+#define LOG_ERROR(...) do { if (0) Log::write(__VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) Log::write(__VA_ARGS__)
+#else
+#define LOG_WARN(...) do { if (0) Log::write(__VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) Log::write(__VA_ARGS__)
+#else
+#define LOG_INFO(...) do { if (0) Log::write(__VA_ARGS__); } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Log::write(__VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do { if (0) Log::write(__VA_ARGS__); } while (0)
+#endif
+
+namespace Log {
+    // Longest line kept, newline included; longer lines are cut
+    constexpr size_t LINE_MAX_LEN = 256;
+
+    // Format one line and queue it (or write it, without the buffer)
+    // The ring buffer and its task are created by the first line and kept
+    // A full buffer drops the line; the count of dropped lines is logged later
+    void write(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+    // Wait until buffered lines are out on Serial, e.g. before deep sleep
+    void flush();
+
+    // Copy the newest log text written since the last call into out, at most
+    // size - 1 bytes starting on a line, nul-terminated (for telemetry)
+    // Returns the length; 0 without the buffer
+    size_t takeRecent(char* out, size_t size);
+}
+
+#endif
@@ -1,66 +1,239 @@
 // E-ink Display Controller
-// 7.5inch black and white model V2 (800x480)
+// Black and white GxEPD2 panels, selected per build env (EPD_PANEL in config.h)
 
 #include <Arduino.h>
 #include "app_state.h"
 #include "wifi_manager.h"
 #include "config_manager.h"
+#include "config_store.h"
 #include "display_driver.h"
 #include "ui_renderer.h"
+#include "frame_diff.h"
+#include "power_manager.h"
+#include "telemetry.h"
+#include "change_watcher.h"
+#include "overlay.h"
+#include "frame_store.h"
+#include "logging.h"
+#include "bench.h"
 
 // Global application state
-AppState appState;
+RTC_DATA_ATTR RtcState rtcState;
+AppState appState(rtcState);
+
+// Count refreshes that failed in a row; kept in RTC memory across deep sleep
+static void recordRefresh(bool success) {
+    if (success) {
+        appState.rtc.failedRefreshes = 0;
+    } else if (appState.rtc.failedRefreshes < 255) {
+        appState.rtc.failedRefreshes++;
+    }
+}
+
+// Seconds until the next refresh: the configured interval, or after a failure
+// FAILED_REFRESH_RETRY_SEC doubling per further failure up to that interval
+static uint32_t nextRefreshSec() {
+    uint32_t intervalSec = appState.config.refreshIntervalSec;
+    uint8_t failures = appState.rtc.failedRefreshes;
+    if (failures == 0) {
+        return intervalSec;
+    }
+    uint32_t retrySec = (uint32_t)FAILED_REFRESH_RETRY_SEC << min((int)failures - 1, 6);
+    return min(retrySec, intervalSec);
+}
+
+#if HEAP_CHECK_ENABLED
+// A steady-state refresh allocates nothing it keeps, so free heap after a cycle
+// must not drift below what it was once sockets and buffers had warmed up
+// A config change re-baselines: its strings are sized to the new values
+static void checkHeap() {
+    static uint32_t cycles = 0;
+    static uint32_t baseline = 0;
+    static uint32_t revision = 0;
+
+    uint32_t freeHeap = ESP.getFreeHeap();
+    cycles++;
+    if (cycles <= HEAP_CHECK_WARMUP_CYCLES || revision != appState.config.revision) {
+        baseline = freeHeap;
+        revision = appState.config.revision;
+        return;
+    }
+
+    if (freeHeap + HEAP_CHECK_SLACK_BYTES < baseline) {
+        LOG_ERROR("HEAP CHECK FAILED: cycle %u kept %u bytes (free %u, largest block %u)",
+                  (unsigned)cycles, (unsigned)(baseline - freeHeap), (unsigned)freeHeap,
+                  (unsigned)ESP.getMaxAllocHeap());
+    } else {
+        LOG_INFO("Heap check: %u bytes free (baseline %u)", (unsigned)freeHeap, (unsigned)baseline);
+    }
+}
+#endif
+
+#if DEEP_SLEEP_ENABLED
+// Sleep until the next refresh is due, counting the time spent awake
+static void sleepUntilNextRefresh() {
+    uint32_t intervalMs = nextRefreshSec() * 1000;
+    uint32_t awakeMs = millis();
+    uint32_t sleepMs = intervalMs > awakeMs + 1000 ? intervalMs - awakeMs : 1000;
+
+    // The panel may still be running the refresh: shut WiFi down meanwhile, then
+    // light sleep until it is done (the display task polls BUSY between sleeps)
+    PowerManager::radioOff();
+    Log::flush();
+    while (DisplayDriver::busy()) {
+        PowerManager::lightSleep(REFRESH_LIGHT_SLEEP_MS);
+        delay(1);
+    }
+
+    DisplayDriver::hibernate();
+    PowerManager::deepSleep(sleepMs);
+}
+#endif
 
 void setup() {
     Serial.begin(115200);
-    delay(1000);
-    Serial.println();
-    Serial.println("=================================");
-    Serial.println("7.5\" e-Paper Rectangle Demo");
-    Serial.println("=================================");
+
+    // Fast wake path: RTC state is valid and the panel still shows the last frame
+    bool wokeFromSleep = PowerManager::wokeFromTimer();
+
+    if (wokeFromSleep) {
+        appState.rtc.wakeCount++;
+        LOG_INFO("\nWoke from deep sleep (wake %u)", (unsigned)appState.rtc.wakeCount);
+    } else {
+        delay(1000);
+        LOG_INFO("\n=================================");
+        LOG_INFO("7.5\" e-Paper Rectangle Demo");
+        LOG_INFO("=================================");
+    }
 
     // Initialize display hardware
-    DisplayDriver::init();
+    DisplayDriver::init(!wokeFromSleep);
     DisplayDriver::setRotation(0);
 
-    // Connect to WiFi
-    WifiManager::setup(appState.wifiMulti);
+#if !DEEP_SLEEP_ENABLED
+    // Keep a copy of the last frame so unchanged regions are not refreshed
+    // (RAM does not survive deep sleep, so only worth it when staying awake)
+    FrameDiff::begin();
+#endif
+
+    // Size image buffers from what is left (PSRAM: one full-frame buffer)
+    UiRenderer::begin(appState);
+
+#if BENCH_CYCLES > 0
+    // Benchmark instead of the refresh loop; loop() then idles
+    Bench::run(appState);
+    return;
+#endif
+
+    Telemetry::beginCycle();
 
-    // Load remote configuration
-    ConfigManager::loadRemoteConfig(appState.config);
+    // With a cached config the frame goes up first and the config is revalidated
+    // afterwards; changes then apply from the next refresh
+    bool cachedConfig = ConfigStore::load(appState.config);
 
-    // Display the initial image
-    Serial.println("Loading initial image...");
-    UiRenderer::showRemoteImage(appState);
+#if FRAME_CACHE_ENABLED
+    // Power-on: put the last good frame up at once instead of a blank panel;
+    // after a timer wake the panel still shows it
+    if (FrameStore::begin() && !wokeFromSleep) {
+        UiRenderer::showCachedFrame(appState);
+    }
+#endif
+
+    // Connect to WiFi; on failure retry at the next refresh
+    if (WifiManager::setup(appState.wifiMulti, appState.rtc.wifi)) {
+        if (!cachedConfig) {
+            ConfigManager::loadRemoteConfig(appState.config, appState.http);
+        }
+
+        // Display the initial image
+        LOG_INFO("Loading initial image...");
+        recordRefresh(UiRenderer::showRemoteImage(appState));
+
+        if (cachedConfig) {
+            ConfigManager::loadRemoteConfig(appState.config, appState.http);
+        }
+        Overlay::begin(appState.config);
+
+        Telemetry::report(appState.config, appState.http);
+    } else {
+        UiRenderer::showWifiError(appState);
+        recordRefresh(false);
+    }
     appState.lastRefreshTime = millis();
 
-    Serial.printf("Image will refresh every %d seconds\n", appState.config.refreshIntervalSec);
+#if DEEP_SLEEP_ENABLED
+    sleepUntilNextRefresh();
+#else
+    LOG_INFO("Image will refresh every %d seconds", appState.config.refreshIntervalSec);
+    if (appState.rtc.failedRefreshes > 0) {
+        LOG_INFO("Retrying in %u seconds", (unsigned)nextRefreshSec());
+    }
+#endif
 }
 
 void loop() {
+#if BENCH_CYCLES > 0
+    delay(1000);
+    return;
+#endif
+
+    // Only reached when DEEP_SLEEP_ENABLED is 0; otherwise setup() ends in deep sleep
     unsigned long currentTime = millis();
-    unsigned long elapsedSeconds = (currentTime - appState.lastRefreshTime) / 1000;
+    unsigned long elapsedMs = currentTime - appState.lastRefreshTime;
+    unsigned long intervalMs = (unsigned long)nextRefreshSec() * 1000;
+    bool refreshDue = elapsedMs >= intervalMs;
+
+    // Until the interval is up, wait on the server for entity changes instead of idling,
+    // but not past the next layout region or overlay text change
+    if (!refreshDue && ChangeWatcher::enabled(appState.config) && WifiManager::isConnected()) {
+        unsigned long waitMs = min(intervalMs - elapsedMs, UiRenderer::msUntilNextRegion(appState));
+        waitMs = min(waitMs, Overlay::msUntilNextChange(appState.config));
+        refreshDue = ChangeWatcher::waitForChange(appState.config, appState.http, waitMs);
+        currentTime = millis();
+        if (refreshDue) {
+            LOG_INFO("Template entities changed. Reloading config and image...");
+        }
+    } else if (refreshDue) {
+        LOG_INFO("Refresh interval reached (%u seconds). Reloading config and image...",
+                 (unsigned)(intervalMs / 1000));
+    }
 
-    // Check if it's time to refresh based on config
-    if (elapsedSeconds >= appState.config.refreshIntervalSec) {
-        Serial.printf("Refresh interval reached (%d seconds). Reloading config and image...\n",
-                      appState.config.refreshIntervalSec);
+    if (refreshDue) {
+        Telemetry::beginCycle();
 
         // Reconnect WiFi if disconnected
-        WifiManager::ensureConnected(appState.wifiMulti);
+        if (WifiManager::ensureConnected(appState.wifiMulti, appState.rtc.wifi)) {
+            // Revalidate configuration (304 when unchanged)
+            ConfigManager::loadRemoteConfig(appState.config, appState.http);
+            Overlay::begin(appState.config);
 
-        // Reload configuration (in case it changed)
-        ConfigManager::loadRemoteConfig(appState.config);
+            // Display the updated image
+            recordRefresh(UiRenderer::showRemoteImage(appState));
 
-        // Display the updated image
-        UiRenderer::showRemoteImage(appState);
+            Telemetry::report(appState.config, appState.http);
+        } else {
+            UiRenderer::showWifiError(appState);
+            recordRefresh(false);
+        }
 
         // Update last refresh time
         appState.lastRefreshTime = currentTime;
 
-        Serial.printf("Next refresh in %d seconds\n", appState.config.refreshIntervalSec);
+#if HEAP_CHECK_ENABLED
+        checkHeap();
+#endif
+
+        LOG_INFO("Next refresh in %u seconds", (unsigned)nextRefreshSec());
     }
 
+    // Regions with a shorter interval than the full image (e.g. a clock)
+    if (WifiManager::isConnected()) {
+        UiRenderer::showDueRegions(appState);
+    }
+
+    // Clock and other local text, drawn without the network
+    Overlay::update(appState);
+
     // Small delay to prevent busy waiting
     delay(1000);
 }
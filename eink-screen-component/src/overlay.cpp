@@ -0,0 +1,156 @@
+#include "overlay.h"
+#include "logging.h"
+#include "app_state.h"
+#include "ui_renderer.h"
+#include <Adafruit_GFX.h>
+#include <limits.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <Fonts/FreeMonoBold9pt7b.h>
+#include <Fonts/FreeMonoBold12pt7b.h>
+#include <Fonts/FreeMonoBold18pt7b.h>
+#include <Fonts/FreeMonoBold24pt7b.h>
+
+namespace Overlay {
+
+// Adafruit_GFX target that draws into caller-owned panel rows (1 = white),
+// so text is rendered in the band buffer instead of the paged framebuffer
+class RowCanvas : public Adafruit_GFX {
+public:
+    RowCanvas(uint8_t* rows, int16_t w, int16_t h) : Adafruit_GFX(w, h), rows(rows), bytesPerRow(w / 8) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (x < 0 || y < 0 || x >= _width || y >= _height) {
+            return;
+        }
+        uint8_t mask = 0x80 >> (x & 7);
+        uint8_t& b = rows[y * bytesPerRow + x / 8];
+        b = color != 0 ? (b | mask) : (b & ~mask);
+    }
+
+private:
+    uint8_t* rows;
+    int16_t bytesPerRow;
+};
+
+static char shownText[MAX_OVERLAYS][TEXT_MAX];
+static uint32_t shownGeneration = 0;
+static String activeTimeZone;
+static String activeNtpServer;
+
+static const GFXfont* fontFor(uint8_t pt) {
+    switch (pt) {
+        case 9: return &FreeMonoBold9pt7b;
+        case 18: return &FreeMonoBold18pt7b;
+        case 24: return &FreeMonoBold24pt7b;
+        default: return &FreeMonoBold12pt7b;
+    }
+}
+
+// Formats that show seconds change every second, all others at most every minute
+static bool showsSeconds(const String& format) {
+    static const char* const SECOND_SPECIFIERS[] = {"%S", "%T", "%X", "%r", "%c", "%s"};
+    for (const char* specifier : SECOND_SPECIFIERS) {
+        if (format.indexOf(specifier) >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Render one slot into buffer and show it
+static void drawSlot(AppState& state, const OverlaySlot& slot, const char* text, uint8_t* buffer) {
+    memset(buffer, 0xFF, (size_t)slot.width / 8 * slot.height);
+
+    RowCanvas canvas(buffer, slot.width, slot.height);
+    canvas.setFont(fontFor(slot.font));
+    canvas.setTextColor(0);
+    canvas.setTextWrap(false);
+
+    int16_t x1, y1;
+    uint16_t textWidth, textHeight;
+    canvas.getTextBounds(text, 0, 0, &x1, &y1, &textWidth, &textHeight);
+
+    int16_t cursorX = -x1;
+    if (slot.align == 'c') {
+        cursorX = (slot.width - textWidth) / 2 - x1;
+    } else if (slot.align == 'r') {
+        cursorX = slot.width - textWidth - x1;
+    }
+    canvas.setCursor(cursorX, (slot.height - textHeight) / 2 - y1);
+    canvas.print(text);
+
+    UiRenderer::writeWindow(buffer, slot.x, slot.y, slot.width, slot.height);
+    UiRenderer::refreshWindow(state, slot.x, slot.y, slot.width, slot.height);
+}
+
+void begin(const RemoteConfig& config) {
+    if (config.overlayCount == 0 || (config.timeZone == activeTimeZone && config.ntpServer == activeNtpServer)) {
+        return;
+    }
+    configTzTime(config.timeZone.c_str(), config.ntpServer.c_str());
+    activeTimeZone = config.timeZone;
+    activeNtpServer = config.ntpServer;
+    LOG_INFO("NTP sync started (%s, %s)", config.ntpServer.c_str(), config.timeZone.c_str());
+}
+
+int update(AppState& state) {
+    const RemoteConfig& config = state.config;
+    if (config.overlayCount == 0 || !UiRenderer::windowsReady()) {
+        return 0;
+    }
+
+    struct tm now;
+    if (!getLocalTime(&now, 0)) {
+        return 0;  // Not synced yet
+    }
+
+    // A new image covered the slots, draw them all again
+    if (UiRenderer::imageGeneration() != shownGeneration) {
+        shownGeneration = UiRenderer::imageGeneration();
+        for (int i = 0; i < MAX_OVERLAYS; i++) {
+            shownText[i][0] = '\0';
+        }
+    }
+
+    int drawn = 0;
+    for (int i = 0; i < config.overlayCount; i++) {
+        const OverlaySlot& slot = config.overlays[i];
+        char text[TEXT_MAX];
+        if (strftime(text, sizeof(text), slot.format.c_str(), &now) == 0 || strcmp(text, shownText[i]) == 0) {
+            continue;
+        }
+
+        if ((size_t)slot.width / 8 * slot.height > state.bandBufferBytes) {
+            LOG_WARN("Overlay %d is larger than the band buffer, skipped", i + 1);
+            continue;
+        }
+
+        drawSlot(state, slot, text, state.bandBuffers[0]);
+        strcpy(shownText[i], text);
+        drawn++;
+    }
+    return drawn;
+}
+
+unsigned long msUntilNextChange(const RemoteConfig& config) {
+    if (config.overlayCount == 0) {
+        return ULONG_MAX;
+    }
+
+    bool seconds = false;
+    for (int i = 0; i < config.overlayCount; i++) {
+        seconds = seconds || showsSeconds(config.overlays[i].format);
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    unsigned long intoSecondMs = tv.tv_usec / 1000;
+    if (seconds) {
+        return 1000 - intoSecondMs;
+    }
+    return (60 - tv.tv_sec % 60) * 1000 - intoSecondMs;
+}
+
+}  // namespace Overlay
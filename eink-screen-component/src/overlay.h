@@ -0,0 +1,28 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+struct AppState;
+
+namespace Overlay {
+    // Longest text of one slot after strftime()
+    constexpr int TEXT_MAX = 32;
+
+    // Start NTP time sync for the overlays (time zone and server from /config)
+    // Call after WiFi is up; only restarts SNTP when the settings changed
+    void begin(const RemoteConfig& config);
+
+    // Render the slots whose text changed since they were drawn and refresh
+    // each in its own partial window; no network traffic
+    // Does nothing until the clock is synced and an image is on the panel
+    // Returns the number of slots redrawn
+    int update(AppState& state);
+
+    // Milliseconds until the text of a slot can change next (second or minute
+    // boundary), ULONG_MAX without overlays
+    unsigned long msUntilNextChange(const RemoteConfig& config);
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include "packbits.h"
+
+void PackBitsDecoder::begin(Stream* input, size_t compressedSize) {
+    stream = input;
+    totalSize = compressedSize;
+    remaining = compressedSize;
+    stalled = false;
+    inputLength = 0;
+    inputPos = 0;
+    literalLeft = 0;
+    repeatLeft = 0;
+    pendingHeader = -1;
+}
+
+void PackBitsDecoder::resume(Stream* input) {
+    stream = input;
+    stalled = false;
+}
+
+bool PackBitsDecoder::refill() {
+    if (remaining == 0 || stalled) {
+        return false;
+    }
+
+    // Never ask for more than the body holds, readBytes would wait out the timeout
+    size_t want = remaining < INPUT_BUFFER_SIZE ? remaining : INPUT_BUFFER_SIZE;
+    inputLength = stream->readBytes(inputBuffer, want);
+    inputPos = 0;
+    if (inputLength == 0) {
+        // Do not wait out the timeout again on every call
+        stalled = true;
+        return false;
+    }
+    remaining -= inputLength;
+    return true;
+}
+
+int PackBitsDecoder::nextByte() {
+    if (inputPos == inputLength && !refill()) {
+        return -1;
+    }
+    return inputBuffer[inputPos++];
+}
+
+size_t PackBitsDecoder::read(uint8_t* out, size_t len) {
+    size_t produced = 0;
+
+    while (produced < len) {
+        if (repeatLeft > 0) {
+            size_t n = (size_t)repeatLeft < len - produced ? repeatLeft : len - produced;
+            memset(out + produced, repeatValue, n);
+            produced += n;
+            repeatLeft -= n;
+            continue;
+        }
+
+        if (literalLeft > 0) {
+            if (inputPos == inputLength && !refill()) {
+                break;
+            }
+            // Copy as much of the literal as is buffered in one go
+            size_t n = literalLeft;
+            n = n < len - produced ? n : len - produced;
+            n = n < inputLength - inputPos ? n : inputLength - inputPos;
+            memcpy(out + produced, inputBuffer + inputPos, n);
+            inputPos += n;
+            produced += n;
+            literalLeft -= n;
+            continue;
+        }
+
+        int header = pendingHeader >= 0 ? pendingHeader : nextByte();
+        pendingHeader = -1;
+        if (header < 0) {
+            break;
+        }
+
+        if (header < 128) {
+            literalLeft = header + 1;
+        } else if (header > 128) {
+            int value = nextByte();
+            if (value < 0) {
+                pendingHeader = header;
+                break;
+            }
+            repeatValue = value;
+            repeatLeft = 257 - header;
+        }
+        // 128 is a no-op
+    }
+
+    return produced;
+}
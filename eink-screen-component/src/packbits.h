@@ -0,0 +1,46 @@
+#ifndef PACKBITS_H
+#define PACKBITS_H
+
+#include <Arduino.h>
+
+// Streaming PackBits decoder
+// Expands a compressed HTTP body straight into caller-sized bands, keeping
+// only a small input buffer and the state of the run being decoded
+struct PackBitsDecoder {
+    static constexpr size_t INPUT_BUFFER_SIZE = 256;
+
+    // Start decoding compressedSize bytes from input
+    void begin(Stream* input, size_t compressedSize);
+
+    // Decode exactly len bytes into out
+    // Returns the number of bytes produced, less than len if the stream ended early
+    size_t read(uint8_t* out, size_t len);
+
+    // Compressed bytes taken from the stream so far, the offset to resume from
+    size_t consumed() const { return totalSize - remaining; }
+
+    // Continue from a new stream starting at consumed() after the old one broke
+    // The state of the run being decoded is kept
+    void resume(Stream* input);
+
+ private:
+    // Pull the next block of compressed bytes, false at end of data / timeout
+    bool refill();
+
+    // Next compressed byte, or -1 at end of data / timeout
+    int nextByte();
+
+    Stream* stream = nullptr;
+    size_t totalSize = 0;
+    size_t remaining = 0;     // Compressed bytes not yet pulled from the stream
+    bool stalled = false;     // Stream stopped delivering, wait for resume()
+    uint8_t inputBuffer[INPUT_BUFFER_SIZE];
+    size_t inputLength = 0;
+    size_t inputPos = 0;
+    int literalLeft = 0;      // Bytes left in the current literal block
+    int repeatLeft = 0;       // Copies left in the current run
+    uint8_t repeatValue = 0;
+    int pendingHeader = -1;   // Run header whose value byte has not arrived yet
+};
+
+#endif
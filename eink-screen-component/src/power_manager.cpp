@@ -0,0 +1,32 @@
+#include "power_manager.h"
+#include "logging.h"
+#include <WiFi.h>
+#include <esp_sleep.h>
+
+namespace PowerManager {
+
+bool wokeFromTimer() {
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+}
+
+void radioOff() {
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+}
+
+void lightSleep(uint32_t sleepMs) {
+    esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000ULL);
+    esp_light_sleep_start();
+}
+
+void deepSleep(uint32_t sleepMs) {
+    LOG_INFO("Deep sleep for %u ms", (unsigned)sleepMs);
+    Log::flush();
+
+    radioOff();
+
+    esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000ULL);
+    esp_deep_sleep_start();
+}
+
+}  // namespace PowerManager
@@ -0,0 +1,23 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+
+namespace PowerManager {
+    // True if this boot is a timer wake from deep sleep (RTC state is valid)
+    bool wokeFromTimer();
+
+    // Shut WiFi down; deepSleep() does this too, calling it earlier lets the
+    // shutdown overlap with a panel refresh
+    void radioOff();
+
+    // Light sleep for up to sleepMs; RAM, tasks and peripherals are kept
+    // Only with the radio off: a light-sleeping station misses its AP's beacons
+    void lightSleep(uint32_t sleepMs);
+
+    // Shut WiFi down and deep sleep for the given time; does not return
+    // The chip resets on wake and starts again from setup()
+    void deepSleep(uint32_t sleepMs);
+}
+
+#endif
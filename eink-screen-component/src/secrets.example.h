@@ -6,4 +6,10 @@
 #define WIFI_SSID "your-wifi-ssid"
 #define WIFI_PASSWORD "your-wifi-password"
 
+// Renderer URL, see DEFAULT_BASE_URL in config.h
+// #define DEFAULT_BASE_URL "https://renderer.example.com"
+
+// Public key pin(s) for an https:// renderer, see TLS_PINS in config.h
+// #define TLS_PINS "0123...cdef"
+
 #endif
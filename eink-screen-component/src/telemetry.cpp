@@ -0,0 +1,146 @@
+#include "telemetry.h"
+#include "logging.h"
+#include <WiFi.h>
+#include <stdarg.h>
+
+namespace Telemetry {
+
+// Keys of the report's "ms" object, in Phase order
+static const char* PHASE_NAMES[PHASE_COUNT] = {"wifi", "config", "ttfb", "download", "write", "refresh"};
+
+// Cycle number survives deep sleep so the server can spot lost reports
+static RTC_DATA_ATTR uint32_t cycle = 0;
+
+static uint32_t cycleStartUs = 0;
+static uint32_t phaseStartUs[PHASE_COUNT];
+static uint32_t phaseTotalUs[PHASE_COUNT];
+static uint16_t requests = 0;
+static uint32_t bytes = 0;
+
+void beginCycle() {
+    cycle++;
+    cycleStartUs = micros();
+    memset(phaseTotalUs, 0, sizeof(phaseTotalUs));
+    requests = 0;
+    bytes = 0;
+}
+
+void start(Phase phase) {
+    phaseStartUs[phase] = micros();
+}
+
+void stop(Phase phase) {
+    phaseTotalUs[phase] += micros() - phaseStartUs[phase];
+}
+
+uint32_t phaseMs(Phase phase) {
+    return phaseTotalUs[phase] / 1000;
+}
+
+const char* phaseName(Phase phase) {
+    return PHASE_NAMES[phase];
+}
+
+void addRequest() {
+    requests++;
+}
+
+void addBytes(size_t count) {
+    bytes += count;
+}
+
+#if TELEMETRY_ENABLED
+// Append printf output to body, keeping count of the length it would have
+static void append(char* body, size_t size, size_t& length, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(body + min(length, size), length < size ? size - length : 0, format, args);
+    va_end(args);
+    length += written > 0 ? written : 0;
+}
+
+#if LOG_TELEMETRY_BYTES > 0
+// Append text as the contents of a JSON string
+static void appendEscaped(char* body, size_t size, size_t& length, const char* text) {
+    for (; *text != '\0'; text++) {
+        char c = *text;
+        if (c == '"' || c == '\\') {
+            append(body, size, length, "\\%c", c);
+        } else if (c == '\n') {
+            append(body, size, length, "\\n");
+        } else if ((uint8_t)c >= 0x20) {
+            append(body, size, length, "%c", c);
+        }
+    }
+}
+#endif
+#endif
+
+// Timings and counters, plus the log lines escaped at worst to two bytes each
+constexpr size_t REPORT_MAX_LEN = 384 + 2 * LOG_TELEMETRY_BYTES + 16;
+
+// Largest body the server's /telemetry accepts (MAX_BODY_BYTES in the renderer)
+constexpr size_t TELEMETRY_MAX_BODY = 4096;
+static_assert(REPORT_MAX_LEN <= TELEMETRY_MAX_BODY,
+              "LOG_TELEMETRY_BYTES too large, the server would reject every report (1800 at most)");
+
+bool report(const RemoteConfig& config, HttpConnection& http) {
+#if TELEMETRY_ENABLED
+    // Formatted in place rather than through a JsonDocument, so the report
+    // costs no heap churn every cycle
+    static char device[18] = "";
+    if (device[0] == '\0') {
+        uint8_t mac[6];
+        WiFi.macAddress(mac);
+        snprintf(device, sizeof(device), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    }
+
+    static char body[REPORT_MAX_LEN];
+    size_t length = 0;
+    append(body, sizeof(body), length, "{\"device\":\"%s\",\"cycle\":%u,\"ms\":{", device, (unsigned)cycle);
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        append(body, sizeof(body), length, "\"%s\":%u,", PHASE_NAMES[i], (unsigned)(phaseTotalUs[i] / 1000));
+    }
+    append(body, sizeof(body), length, "\"total\":%u},\"requests\":%u,\"bytes\":%u,\"rssi\":%d,",
+           (unsigned)((micros() - cycleStartUs) / 1000), (unsigned)requests, (unsigned)bytes, (int)WiFi.RSSI());
+    append(body, sizeof(body), length, "\"heap\":{\"free\":%u,\"largest\":%u,\"min\":%u}",
+           (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMaxAllocHeap(), (unsigned)ESP.getMinFreeHeap());
+#if LOG_TELEMETRY_BYTES > 0
+    // Lines logged since the previous report, newest kept
+    static char recent[LOG_TELEMETRY_BYTES + 1];
+    if (Log::takeRecent(recent, sizeof(recent)) > 0) {
+        append(body, sizeof(body), length, ",\"log\":\"");
+        appendEscaped(body, sizeof(body), length, recent);
+        append(body, sizeof(body), length, "\"");
+    }
+#endif
+    append(body, sizeof(body), length, "}");
+    if (length >= sizeof(body)) {
+        LOG_ERROR("Telemetry report too long, not sent");
+        return false;
+    }
+
+    char url[URL_MAX_LEN];
+    snprintf(url, sizeof(url), "%s%s", config.imageBaseUrl.c_str(), TELEMETRY_PATH);
+    if (!http.begin(url, 5000)) {
+        return false;
+    }
+
+    int httpCode = http.post("application/json", (const uint8_t*)body, length);
+    if (httpCode == 200 || httpCode == 204) {
+        http.end();
+        LOG_DEBUG("Telemetry sent: %s", body);
+        return true;
+    }
+
+    http.close();
+    LOG_WARN("Telemetry rejected: %d", httpCode);
+#else
+    (void)config;
+    (void)http;
+#endif
+    return false;
+}
+
+}  // namespace Telemetry
@@ -0,0 +1,47 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "http_client.h"
+
+namespace Telemetry {
+    // Timed phases of one refresh cycle; times add up over repeated phases
+    enum Phase {
+        PHASE_WIFI,      // Association and DHCP
+        PHASE_CONFIG,    // /config request
+        PHASE_TTFB,      // Image request sent until response headers (per request, summed)
+        PHASE_DOWNLOAD,  // Reading image data off the socket
+        PHASE_WRITE,     // SPI writes into controller RAM
+        PHASE_REFRESH,   // Choosing and queueing the refresh (the waveform runs behind later phases)
+        PHASE_COUNT
+    };
+
+    // Reset counters at the start of a refresh cycle
+    void beginCycle();
+
+    // Time a phase; start/stop pairs may repeat within a cycle
+    void start(Phase phase);
+    void stop(Phase phase);
+
+    // Milliseconds spent in a phase this cycle, and its key in the report
+    uint32_t phaseMs(Phase phase);
+    const char* phaseName(Phase phase);
+
+    // Count one image request and the image bytes it delivered
+    void addRequest();
+    void addBytes(size_t bytes);
+
+    // POST the cycle report (timings, RSSI, heap) to {base_url}/telemetry
+    // Returns true if the server accepted it; no-op when TELEMETRY_ENABLED is 0
+    bool report(const RemoteConfig& config, HttpConnection& http);
+
+    // Times the enclosing scope
+    struct PhaseTimer {
+        Phase phase;
+        explicit PhaseTimer(Phase p) : phase(p) { start(phase); }
+        ~PhaseTimer() { stop(phase); }
+    };
+}
+
+#endif
@@ -0,0 +1,355 @@
+#include "tls_client.h"
+#include "logging.h"
+#include "config.h"
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/x509_crt.h>
+
+// The pin is the only check on the server (no CA chain), so every handshake
+// must have its peer certificate, including resumed ones (kept in the session)
+#if !defined(MBEDTLS_SSL_KEEP_PEER_CERTIFICATE)
+#error "TlsClient needs MBEDTLS_SSL_KEEP_PEER_CERTIFICATE to check TLS_PINS"
+#endif
+
+constexpr int32_t TLS_TIMEOUT_MS = 10000;  // connect() without a timeout
+constexpr size_t PIN_HEX_LEN = 64;
+
+struct TlsClient::Context {
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_ssl_config config;
+    mbedtls_ssl_context ssl;
+};
+
+void TlsClient::freeContext(Context* context) {
+    mbedtls_ssl_free(&context->ssl);
+    mbedtls_ssl_config_free(&context->config);
+    mbedtls_ctr_drbg_free(&context->drbg);
+    mbedtls_entropy_free(&context->entropy);
+    delete context;
+}
+
+// Record I/O over the plain socket; the qualified calls skip TlsClient's overrides
+static int socketSend(void* socket, const unsigned char* buf, size_t len) {
+    size_t sent = static_cast<WiFiClient*>(socket)->WiFiClient::write(buf, len);
+    return sent > 0 ? (int)sent : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+static int socketRecv(void* socket, unsigned char* buf, size_t len) {
+    WiFiClient* client = static_cast<WiFiClient*>(socket);
+    int received = client->WiFiClient::read(buf, len);
+    if (received > 0) {
+        return received;
+    }
+    return client->WiFiClient::connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+}
+
+// True if the hex digest is one of the comma separated TLS_PINS
+static bool pinned(const char* digest) {
+    const char* pin = TLS_PINS;
+    while (*pin != '\0') {
+        pin += strspn(pin, ", ");
+        size_t length = strcspn(pin, ", ");
+        if (length == PIN_HEX_LEN && strncasecmp(pin, digest, PIN_HEX_LEN) == 0) {
+            return true;
+        }
+        pin += length;
+    }
+    return false;
+}
+
+TlsClient::~TlsClient() {
+    if (tls != nullptr) {
+        freeContext(tls);
+    }
+}
+
+void TlsClient::setSessionCache(TlsSession* cache) {
+    sessionCache = cache;
+}
+
+bool TlsClient::setup() {
+    if (tls != nullptr) {
+        return true;
+    }
+
+    Context* context = new Context();
+    mbedtls_entropy_init(&context->entropy);
+    mbedtls_ctr_drbg_init(&context->drbg);
+    mbedtls_ssl_config_init(&context->config);
+    mbedtls_ssl_init(&context->ssl);
+
+    int ret = mbedtls_ctr_drbg_seed(&context->drbg, mbedtls_entropy_func, &context->entropy, nullptr, 0);
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(&context->config, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret == 0) {
+        // Trust comes from the public key pin, checked after the handshake
+        mbedtls_ssl_conf_authmode(&context->config, MBEDTLS_SSL_VERIFY_NONE);
+        mbedtls_ssl_conf_rng(&context->config, mbedtls_ctr_drbg_random, &context->drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        mbedtls_ssl_conf_session_tickets(&context->config, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+        // Record buffers are allocated here once and reused by every connection
+        ret = mbedtls_ssl_setup(&context->ssl, &context->config);
+    }
+
+    if (ret != 0) {
+        LOG_ERROR("TLS setup failed (-0x%04x)", (unsigned)-ret);
+        freeContext(context);
+        return false;
+    }
+    tls = context;
+    return true;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip, port, TLS_TIMEOUT_MS);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+    char host[16];
+    snprintf(host, sizeof(host), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    return connect(host, port, timeoutMs);
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, TLS_TIMEOUT_MS);
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    stop();
+    if (TLS_PINS[0] == '\0') {
+        LOG_ERROR("https:// needs the server's public key in TLS_PINS (config.h)");
+        return 0;
+    }
+    if (!setup() || !WiFiClient::connect(host, port, timeoutMs)) {
+        return 0;
+    }
+    if (!handshake(host, timeoutMs)) {
+        WiFiClient::stop();
+        return 0;
+    }
+    return 1;
+}
+
+// Offer the cached session for host; the server either resumes it or falls
+// back to a full handshake by itself
+bool TlsClient::offerSession(const char* host) {
+    if (sessionCache == nullptr || sessionCache->length == 0 || strcmp(sessionCache->host, host) != 0) {
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    bool offered = mbedtls_ssl_session_load(&session, sessionCache->data, sessionCache->length) == 0 &&
+                   mbedtls_ssl_set_session(&tls->ssl, &session) == 0;
+    mbedtls_ssl_session_free(&session);
+
+    if (!offered) {
+        sessionCache->length = 0;
+    }
+    return offered;
+}
+
+bool TlsClient::handshake(const char* host, int32_t timeoutMs) {
+    unsigned long startMs = millis();
+    peeked = -1;
+
+    // SNI carries names only, not address literals
+    bool literal = IPAddress().fromString(host);
+    mbedtls_ssl_session_reset(&tls->ssl);
+    mbedtls_ssl_set_hostname(&tls->ssl, literal ? nullptr : host);
+    mbedtls_ssl_set_bio(&tls->ssl, static_cast<WiFiClient*>(this), socketSend, socketRecv, nullptr);
+    bool offered = offerSession(host);
+
+    int ret;
+    while ((ret = mbedtls_ssl_handshake(&tls->ssl)) != 0) {
+        bool pending = ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+        if (!pending || millis() - startMs > (unsigned long)timeoutMs) {
+            LOG_ERROR("TLS handshake with %s failed (-0x%04x)", host, (unsigned)-ret);
+            if (offered) {
+                sessionCache->length = 0;
+            }
+            return false;
+        }
+        delay(1);
+    }
+
+    if (!pinMatches()) {
+        if (sessionCache != nullptr) {
+            sessionCache->length = 0;
+        }
+        return false;
+    }
+
+    established = true;
+    saveSession(host);
+    LOG_INFO("TLS with %s in %lu ms (%s)", host, millis() - startMs,
+             offered ? "session offered" : "full handshake");
+    return true;
+}
+
+bool TlsClient::pinMatches() {
+    // Offering a session proves nothing: the server may have ignored it and
+    // done a full handshake, so an unknown key is refused, never assumed
+    const mbedtls_x509_crt* cert = mbedtls_ssl_get_peer_cert(&tls->ssl);
+    if (cert == nullptr) {
+        LOG_ERROR("TLS server sent no certificate, refusing it");
+        return false;
+    }
+
+    uint8_t hash[32];
+    if (mbedtls_sha256_ret(cert->pk_raw.p, cert->pk_raw.len, hash, 0) != 0) {
+        return false;
+    }
+    char digest[PIN_HEX_LEN + 1];
+    for (size_t i = 0; i < sizeof(hash); i++) {
+        snprintf(digest + i * 2, 3, "%02x", hash[i]);
+    }
+
+    if (!pinned(digest)) {
+        LOG_ERROR("TLS public key %s is not in TLS_PINS, refusing the server", digest);
+        return false;
+    }
+    return true;
+}
+
+void TlsClient::saveSession(const char* host) {
+    if (sessionCache == nullptr) {
+        return;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    size_t length = 0;
+    bool saved = strlen(host) < sizeof(sessionCache->host) &&
+                 mbedtls_ssl_get_session(&tls->ssl, &session) == 0 &&
+                 mbedtls_ssl_session_save(&session, sessionCache->data, sizeof(sessionCache->data), &length) == 0;
+    mbedtls_ssl_session_free(&session);
+
+    if (!saved) {
+        LOG_WARN("TLS session too large to cache, next connection does a full handshake");
+        sessionCache->length = 0;
+        return;
+    }
+    strcpy(sessionCache->host, host);
+    sessionCache->length = length;
+}
+
+// The socket failed or the server closed it; nothing left to send close_notify on
+void TlsClient::drop() {
+    established = false;
+    WiFiClient::stop();
+}
+
+size_t TlsClient::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size) {
+    if (!established) {
+        return 0;
+    }
+
+    unsigned long startMs = millis();
+    size_t sent = 0;
+    while (sent < size) {
+        int ret = mbedtls_ssl_write(&tls->ssl, buf + sent, size - sent);
+        if (ret > 0) {
+            sent += ret;
+            continue;
+        }
+        bool pending = ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+        if (!pending || millis() - startMs > (unsigned long)TLS_TIMEOUT_MS) {
+            drop();
+            break;
+        }
+        delay(1);
+    }
+    return sent;
+}
+
+int TlsClient::available() {
+    if (!established) {
+        return 0;
+    }
+
+    size_t ready = mbedtls_ssl_get_bytes_avail(&tls->ssl);
+    if (ready == 0 && WiFiClient::available() > 0) {
+        // Decrypt the next record without consuming any of it
+        int ret = mbedtls_ssl_read(&tls->ssl, nullptr, 0);
+        if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            drop();
+            return peeked >= 0 ? 1 : 0;
+        }
+        ready = mbedtls_ssl_get_bytes_avail(&tls->ssl);
+    }
+    return (int)ready + (peeked >= 0 ? 1 : 0);
+}
+
+// Like WiFiClient::read(): 0 when nothing has arrived yet, -1 once closed
+int TlsClient::read(uint8_t* buf, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    size_t count = 0;
+    if (peeked >= 0) {
+        buf[count++] = (uint8_t)peeked;
+        peeked = -1;
+    }
+    if (!established || count == size) {
+        return count > 0 ? (int)count : -1;
+    }
+
+    int ret = mbedtls_ssl_read(&tls->ssl, buf + count, size - count);
+    if (ret > 0) {
+        return (int)count + ret;
+    }
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        return (int)count;
+    }
+
+    // 0 or MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY: the server closed; anything else is an error
+    drop();
+    return count > 0 ? (int)count : -1;
+}
+
+int TlsClient::read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int TlsClient::peek() {
+    if (peeked < 0) {
+        uint8_t b;
+        if (read(&b, 1) == 1) {
+            peeked = b;
+        }
+    }
+    return peeked;
+}
+
+// Writes go out in write(); WiFiClient::flush() would discard received data
+void TlsClient::flush() {}
+
+void TlsClient::stop() {
+    if (established && WiFiClient::connected()) {
+        mbedtls_ssl_close_notify(&tls->ssl);
+    }
+    established = false;
+    peeked = -1;
+    WiFiClient::stop();
+}
+
+uint8_t TlsClient::connected() {
+    if (!established) {
+        return 0;
+    }
+    return peeked >= 0 || mbedtls_ssl_get_bytes_avail(&tls->ssl) > 0 || WiFiClient::connected();
+}
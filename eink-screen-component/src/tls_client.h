@@ -0,0 +1,55 @@
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include <WiFiClient.h>
+#include "http_client.h"
+
+// TLS over the WiFiClient socket for HttpConnection
+// The server is trusted by its public key (TLS_PINS in config.h), not by a
+// CA chain. Each handshake saves its session to the cache so the next
+// connection, also after deep sleep, resumes it (session ticket or ID) at
+// a fraction of the cost of a full handshake
+// mbedTLS state is created on the first connect and kept between connections
+class TlsClient : public WiFiClient {
+public:
+    ~TlsClient();
+
+    // Session resumption cache (RTC memory); nullptr for full handshakes only
+    void setSessionCache(TlsSession* cache);
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs) override;
+    int connect(const char* host, uint16_t port) override;
+    int connect(const char* host, uint16_t port, int32_t timeoutMs) override;
+
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+
+    // Decrypted bytes ready to read
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+
+    // Send close_notify and close the socket
+    void stop() override;
+    uint8_t connected() override;
+
+private:
+    struct Context;
+    Context* tls = nullptr;
+    TlsSession* sessionCache = nullptr;
+    bool established = false;
+    int peeked = -1;  // Byte returned by peek(), not yet read
+
+    static void freeContext(Context* context);
+    bool setup();
+    bool offerSession(const char* host);
+    bool handshake(const char* host, int32_t timeoutMs);
+    bool pinMatches();
+    void saveSession(const char* host);
+    void drop();
+};
+
+#endif
@@ -1,9 +1,16 @@
 #include "ui_renderer.h"
+#include "logging.h"
 #include "app_state.h"
 #include "display_driver.h"
 #include "config_manager.h"
 #include "http_client.h"
 #include "error_icons.h"
+#include "frame_diff.h"
+#include "packbits.h"
+#include "band_pipeline.h"
+#include "telemetry.h"
+#include "frame_store.h"
+#include <limits.h>
 
 // Include fonts for error screen
 #include <Fonts/FreeMonoBold9pt7b.h>
@@ -55,7 +62,7 @@ void showErrorIndicator(const uint8_t* icon) {
         }
     } while (DisplayDriver::nextPage());
 
-    Serial.println("Error indicator displayed in top-right corner");
+    LOG_INFO("Error indicator displayed in top-right corner");
 }
 
 void showError(const char* errorMsg, int errorCode, const uint8_t* icon) {
@@ -185,100 +192,817 @@ void showError(const char* errorMsg, int errorCode, const uint8_t* icon) {
 
     } while (DisplayDriver::nextPage());
 
-    Serial.println("Error screen displayed");
+    LOG_INFO("Error screen displayed");
 }
 
-bool showRemoteImage(AppState& state) {
-    DisplayDriver::setFullWindow();
-    DisplayDriver::firstPage();
+// Outcome of fetching the remote image
+enum class ImageFetch {
+    Received,     // New frame data arrived from the server
+    NotModified,  // Server answered 304, the panel already shows this frame
+    Failed        // Error already reported on screen
+};
+
+// Set while a fetched image streams into controller RAM, see writeBand()
+static bool recordFrame = false;
+
+// Show a failure without losing a good image: corner indicator if the previous
+// render succeeded, full error screen otherwise
+static void reportImageError(AppState& state, const char* message, int errorCode, const uint8_t* icon) {
+    FrameStore::discard();
+    recordFrame = false;
+
+    // Nothing good on the panel yet (e.g. offline at boot): the last frame from
+    // flash beats an error screen
+    if (!state.rtc.lastRenderSuccess) {
+        showCachedFrame(state);
+    }
+
+    // The panel no longer shows exactly the stored frame, force a full fetch next time
+    state.rtc.imageEtag[0] = '\0';
+    FrameDiff::invalidate();
+
+    if (state.rtc.lastRenderSuccess) {
+        showErrorIndicator(icon);
+    } else {
+        showError(message, errorCode, icon);
+    }
+}
+
+void showWifiError(AppState& state) {
+    reportImageError(state, "WiFi connection failed", 0, ICON_WIFI_ERROR);
+}
+
+// A failed image request, reported on screen by the caller
+struct ImageError {
+    const char* message;
+    int code;
+    const uint8_t* icon;
+    bool retryable;  // Network trouble that may pass, not an answer the server would repeat
+};
+
+// Wait before retry attempt (1-based): exponential backoff with jitter, so
+// devices behind the same flaky access point do not retry in step
+static void backoff(int attempt) {
+    uint32_t waitMs = (IMAGE_RETRY_BASE_MS << (attempt - 1)) + random(IMAGE_RETRY_BASE_MS);
+    LOG_WARN("Retry %d/%d in %u ms", attempt, IMAGE_RETRIES, (unsigned)waitMs);
+    delay(waitMs);
+}
+
+// Issue the GET for an image URL and validate the response
+// expectedBytes <= 0 when the body size is not known up front
+// ifNoneMatch (optional) lets the server answer 304 when the frame is unchanged
+// Nothing is drawn; on failure error says what went wrong
+static ImageFetch requestUrl(HttpConnection& http, const char* url, int expectedBytes,
+                             const char* ifNoneMatch, ImageError& error) {
+    if (url[0] == '\0') {
+        error = {"Image URL too long", 0, ICON_SERVER_ERROR, false};
+        return ImageFetch::Failed;
+    }
+    LOG_DEBUG("URL: %s", url);
+
+    if (!http.begin(url, 50000)) {
+        LOG_ERROR("WiFi not connected");
+        error = {"WiFi not connected", 0, ICON_WIFI_ERROR, true};
+        return ImageFetch::Failed;
+    }
+
+    if (ifNoneMatch != nullptr && ifNoneMatch[0] != '\0') {
+        http.setIfNoneMatch(ifNoneMatch);
+    }
+
+    Telemetry::addRequest();
+    Telemetry::start(Telemetry::PHASE_TTFB);
+    int httpCode = http.get();
+    Telemetry::stop(Telemetry::PHASE_TTFB);
+    LOG_DEBUG("HTTP response: %d", httpCode);
+
+    if (httpCode == 304) {
+        http.end();
+        return ImageFetch::NotModified;
+    }
+
+    if (httpCode != 200) {
+        LOG_ERROR("HTTP request failed: %d", httpCode);
+        http.close();
+        error = {"HTTP request failed", httpCode, ICON_HTTP_ERROR, httpCode < 0 || httpCode >= 500};
+        return ImageFetch::Failed;
+    }
+
+    int sz = http.getResponseSize();
+    LOG_DEBUG("Response size: %d bytes", sz);
+
+    if (sz <= 0) {
+        LOG_ERROR("Invalid response size");
+        http.close();
+        error = {"Invalid response size", 0, ICON_HTTP_ERROR, false};
+        return ImageFetch::Failed;
+    }
+
+    if (expectedBytes > 0 && sz != expectedBytes) {
+        LOG_WARN("Warning: expected %d bytes, server sent %d bytes", expectedBytes, sz);
+    }
+
+    return ImageFetch::Received;
+}
+
+// Image URL built once per config revision; chunk ranges are written after
+// its query in place, so requests format only a few digits and allocate nothing
+static char imageUrl[URL_MAX_LEN];
+static int imageUrlLength = 0;
+static uint32_t imageUrlRevision = 0;
+
+// URL of one byte range of the full image, limitBytes <= 0 for the whole body
+// Empty if the configured URL does not fit
+static const char* rangeUrl(const RemoteConfig& config, int offsetBytes, int limitBytes) {
+    if (imageUrlLength == 0 || imageUrlRevision != config.revision) {
+        imageUrlLength = ConfigManager::buildImageUrl(config, imageUrl, sizeof(imageUrl));
+        imageUrlRevision = config.revision;
+    }
+
+    if (imageUrlLength > 0 && limitBytes > 0) {
+        snprintf(imageUrl + imageUrlLength, sizeof(imageUrl) - imageUrlLength,
+                 "&offset=%d&limit=%d", offsetBytes, limitBytes);
+    } else {
+        imageUrl[imageUrlLength] = '\0';
+    }
+    return imageUrl;
+}
+
+// requestUrl() for one byte range of the full image
+// limitBytes <= 0 requests the whole body
+static ImageFetch requestImage(AppState& state, HttpConnection& http, int offsetBytes, int limitBytes,
+                               const char* ifNoneMatch, ImageError& error) {
+    return requestUrl(http, rangeUrl(state.config, offsetBytes, limitBytes), limitBytes, ifNoneMatch, error);
+}
+
+// requestUrl() with backoff retries for network failures
+static ImageFetch requestWithRetries(HttpConnection& http, const char* url, int expectedBytes,
+                                     const char* ifNoneMatch, ImageError& error) {
+    for (int attempt = 0;; attempt++) {
+        if (attempt > 0) {
+            backoff(attempt);
+        }
+        ImageFetch result = requestUrl(http, url, expectedBytes, ifNoneMatch, error);
+        if (result != ImageFetch::Failed || !error.retryable || attempt == IMAGE_RETRIES) {
+            return result;
+        }
+    }
+}
+
+// Retried request for a byte range of the full image
+// Reports the final failure on screen and returns Failed
+static ImageFetch openImageRequest(AppState& state, HttpConnection& http, int offsetBytes, int limitBytes,
+                                   const char* ifNoneMatch = nullptr) {
+    ImageError error;
+    ImageFetch result = requestWithRetries(http, rangeUrl(state.config, offsetBytes, limitBytes), limitBytes,
+                                           ifNoneMatch, error);
+    if (result == ImageFetch::Failed) {
+        reportImageError(state, error.message, error.code, error.icon);
+    }
+    return result;
+}
+
+// Byte offset of the first pixel row in the response body
+// "epd1" (and decoded "rle") is bare panel rows, "bmp" starts with its header
+static int pixelDataOffset(const RemoteConfig& config) {
+    return config.imageFormat == "bmp" ? BMP_HEADER_SIZE : 0;
+}
 
-    int totalPixels = state.config.displayWidth * state.config.displayHeight;
-    int pixelsPerChunk = totalPixels / RENDER_CHUNKS;
-    int bytesPerChunk = pixelsPerChunk / 8;
-    int rowsPerChunk = state.config.displayHeight / RENDER_CHUNKS;
+// Write a band straight into controller RAM; the panel refreshes once per image
+// Rows are already in controller layout and polarity (BMP palette index 1 is white)
+static void writeBand(AppState& state, const uint8_t* band, int yPos, int rows) {
+    Telemetry::PhaseTimer timer(Telemetry::PHASE_WRITE);
 
-    Serial.printf("Starting incremental render: %d chunks of %d pixels (%d bytes, %d rows) each\n",
-                  RENDER_CHUNKS, pixelsPerChunk, bytesPerChunk, rowsPerChunk);
+    if (recordFrame) {
+        if (yPos == 0) {
+            FrameStore::beginWrite(state.config.displayWidth, state.config.displayHeight);
+        }
+        FrameStore::write(band, rows * DisplayDriver::BYTES_PER_ROW);
+    }
+
+    if (FrameDiff::enabled()) {
+        // writeImage() first: it waits until the display task has written the
+        // last frame to previous-image RAM, and compareBand() overwrites that frame
+        DisplayDriver::writeImage(band, 0, yPos, DisplayDriver::WIDTH, rows);
+        FrameDiff::compareBand(band, yPos, rows);
+    } else {
+        DisplayDriver::writeImageForFullRefresh(band, 0, yPos, DisplayDriver::WIDTH, rows);
+    }
+}
+
+// Fast partial refreshes since the last full waveform, and when that ran
+static uint16_t partialsSinceFull = 0;
+static unsigned long lastFullRefreshMs = 0;
+
+static RefreshMode refreshMode = REFRESH_AUTO;
+
+// Partial waveforms leave ghosting that only a full refresh clears; allow
+// them for partialRefreshCycles frames or fullRefreshMinutes, whichever ends first
+static bool partialAllowed(const RemoteConfig& config) {
+    if (config.partialRefreshCycles == 0 || partialsSinceFull >= config.partialRefreshCycles) {
+        return false;
+    }
+    return config.fullRefreshMinutes == 0 ||
+           millis() - lastFullRefreshMs < (unsigned long)config.fullRefreshMinutes * 60000UL;
+}
+
+static void fullRefresh() {
+    DisplayDriver::refresh();
+    partialsSinceFull = 0;
+    lastFullRefreshMs = millis();
+}
+
+// Refresh only what changed since the last frame with the fast waveform,
+// a large change as one fast full-screen pass, and run the full waveform
+// when the ghosting budget is used up
+static void refreshFrame(AppState& state) {
+    if (refreshMode == REFRESH_NONE) {
+        // The frame stays in controller RAM; the stored frame still matches the panel
+        return;
+    }
+    if (refreshMode == REFRESH_WINDOW) {
+        DisplayDriver::refresh(0, 0, state.config.displayWidth, state.config.displayHeight);
+        if (FrameDiff::enabled()) {
+            DisplayDriver::writeImageAgain(FrameDiff::frame(), 0, 0, state.config.displayWidth,
+                                           state.config.displayHeight);
+            FrameDiff::commit();
+        }
+        return;
+    }
+
+    if (!FrameDiff::enabled()) {
+        DisplayDriver::refresh();
+        return;
+    }
+
+    FrameDiff::Rect rects[FrameDiff::MAX_RECTS];
+    int rectCount = FrameDiff::dirtyRects(rects, FrameDiff::MAX_RECTS);
+    int percent = FrameDiff::dirtyPercent();
+
+    if (rectCount == 0 && FrameDiff::hasPrevious()) {
+        // Both controller RAMs already hold this frame
+        LOG_INFO("Frame identical to panel, no refresh needed");
+        FrameDiff::commit();
+        return;
+    }
+    if (!FrameDiff::hasPrevious() || !partialAllowed(state.config)) {
+        LOG_INFO("Full refresh (%d%% changed, %u partial since last)", percent, (unsigned)partialsSinceFull);
+        fullRefresh();
+    } else if (percent > FrameDiff::FULL_REFRESH_PERCENT) {
+        LOG_INFO("Fast full-screen refresh (%d%% changed)", percent);
+        DisplayDriver::refresh(true);
+        partialsSinceFull++;
+    } else {
+        LOG_INFO("Partial refresh: %d region(s), %d%% changed", rectCount, percent);
+        for (int i = 0; i < rectCount; i++) {
+            LOG_DEBUG("  Region %d: %dx%d at (%d,%d)", i + 1, rects[i].w, rects[i].h, rects[i].x, rects[i].y);
+            DisplayDriver::refresh(rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+        }
+        partialsSinceFull++;
+    }
+
+    // Controller diffs against its previous-image RAM, bring it up to date
+    DisplayDriver::writeImageAgain(FrameDiff::frame(), 0, 0, state.config.displayWidth, state.config.displayHeight);
+    FrameDiff::commit();
+}
+
+// How a frame of the server-declared size is split over the band buffers
+// Rows are always full panel width (planBands() checks the server size)
+struct BandLayout {
+    static constexpr int bytesPerRow = DisplayDriver::BYTES_PER_ROW;
+    int height;
+    int rowsPerBand;
+    int bandCount;
+
+    int rows(int band) const {
+        return min(rowsPerBand, height - band * rowsPerBand);
+    }
+
+    int bytes(int band) const {
+        return rows(band) * bytesPerRow;
+    }
+};
+
+// Check the declared size against the panel and buffers and plan the bands
+static bool planBands(const AppState& state, BandLayout& layout) {
+    int width = state.config.displayWidth;
+    int height = state.config.displayHeight;
+
+    // Rows are written full width, so the frame must match the panel width
+    if (width != DisplayDriver::WIDTH || height <= 0 || height > DisplayDriver::HEIGHT) {
+        LOG_ERROR("Server size %dx%d does not fit the %dx%d panel",
+                  width, height, DisplayDriver::WIDTH, DisplayDriver::HEIGHT);
+        return false;
+    }
+
+    layout.height = height;
+    layout.rowsPerBand = min(height, (int)(state.bandBufferBytes / layout.bytesPerRow));
+    if (layout.rowsPerBand <= 0) {
+        LOG_ERROR("No image buffer allocated");
+        return false;
+    }
+    layout.bandCount = (height + layout.rowsPerBand - 1) / layout.rowsPerBand;
+    return true;
+}
 
-    for (int chunk = 0; chunk < RENDER_CHUNKS; chunk++) {
-        int chunkOffsetBytes = BMP_HEADER_SIZE + (chunk * bytesPerChunk);
-        int chunkLimitBytes = bytesPerChunk;
+// One request per chunk, each with its own offset/limit
+// Only the first chunk is conditional; etag is cleared if chunks disagree
+// A chunk that fails or arrives short is retried with backoff, resuming
+// after the bytes already received
+static ImageFetch showChunkedImage(AppState& state, const BandLayout& layout, char* etag) {
+    uint8_t* buffer = state.bandBuffers[0];
+    HttpConnection& http = state.http;
+
+    for (int chunk = 0; chunk < layout.bandCount; chunk++) {
+        int chunkBytes = layout.bytes(chunk);
+        int chunkOffsetBytes = pixelDataOffset(state.config) + chunk * layout.rowsPerBand * layout.bytesPerRow;
+
+        LOG_DEBUG("Chunk %d/%d - offset=%d bytes, limit=%d bytes",
+                  chunk + 1, layout.bandCount, chunkOffsetBytes, chunkBytes);
+
+        int filled = 0;
+        ImageError error;
+        for (int attempt = 0; filled < chunkBytes; attempt++) {
+            if (attempt > 0) {
+                if (!error.retryable || attempt > IMAGE_RETRIES) {
+                    reportImageError(state, error.message, error.code, error.icon);
+                    return ImageFetch::Failed;
+                }
+                backoff(attempt);
+            }
 
-        String url = ConfigManager::buildImageUrl(state.config, chunkOffsetBytes, chunkLimitBytes);
+            bool first = chunk == 0 && filled == 0;
+            ImageFetch result = requestImage(state, http, chunkOffsetBytes + filled, chunkBytes - filled,
+                                             first ? state.rtc.imageEtag : nullptr, error);
+            if (result == ImageFetch::NotModified) {
+                return result;
+            }
+            if (result == ImageFetch::Failed) {
+                continue;
+            }
 
-        Serial.printf("Chunk %d/%d - offset=%d bytes, limit=%d bytes\n",
-                      chunk + 1, RENDER_CHUNKS, chunkOffsetBytes, chunkLimitBytes);
-        Serial.printf("URL: %s\n", url.c_str());
+            const char* chunkEtag = http.getETag();
+            if (first) {
+                strcpy(etag, chunkEtag);
+            } else if (strcmp(chunkEtag, etag) != 0) {
+                // Server re-rendered between requests, the frame may be mixed
+                LOG_WARN("Warning: image changed between chunks");
+                etag[0] = '\0';
+            }
 
-        HttpConnection http;
-        if (!http.begin(url, 50000)) {
-            Serial.println("WiFi not connected");
-            if (state.lastRenderSuccess) {
-                showErrorIndicator(ICON_WIFI_ERROR);
+            WiFiClient* stream = http.getStream();
+            Telemetry::start(Telemetry::PHASE_DOWNLOAD);
+            int bytesRead = stream->readBytes(buffer + filled, chunkBytes - filled);
+            Telemetry::stop(Telemetry::PHASE_DOWNLOAD);
+            Telemetry::addBytes(bytesRead);
+            LOG_DEBUG("Read %d bytes of image data", bytesRead);
+            filled += bytesRead;
+
+            if (filled < chunkBytes) {
+                LOG_WARN("Warning: incomplete read. Expected %d, got %d", chunkBytes, filled);
+                error = {"Incomplete image data", 0, ICON_HTTP_ERROR, true};
+                // Unread body bytes would corrupt the next response on this socket
+                http.close();
             } else {
-                showError("WiFi not connected", 0, ICON_WIFI_ERROR);
+                http.end();
             }
-            return false;
         }
 
-        int httpCode = http.get();
-        Serial.printf("HTTP response: %d\n", httpCode);
+        writeBand(state, buffer, chunk * layout.rowsPerBand, layout.rows(chunk));
+        LOG_DEBUG("Chunk %d/%d complete", chunk + 1, layout.bandCount);
+    }
 
-        if (httpCode != 200) {
-            Serial.printf("HTTP request failed: %d\n", httpCode);
-            http.end();
-            if (state.lastRenderSuccess) {
-                showErrorIndicator(ICON_HTTP_ERROR);
-            } else {
-                showError("HTTP request failed", httpCode, ICON_HTTP_ERROR);
+    return ImageFetch::Received;
+}
+
+// Band source and sink for the streamed pipeline
+struct StreamedImage {
+    AppState* state;
+    const BandLayout* layout;
+    HttpConnection* http;
+    WiFiClient* stream;
+    PackBitsDecoder* decoder;  // nullptr for uncompressed bodies
+    int bodyOffset;            // Server offset of the first body byte
+    int bodyBytes;             // Body length, compressed for rle
+    int received;              // Uncompressed body bytes read so far
+    const char* etag;          // Frame the body belongs to, resumes must match
+    int retriesLeft;           // Shared by all bands of the image
+};
+
+// Reopen a broken stream at the first body byte not yet received
+// Runs on the network task, so failures are only logged
+static bool resumeStream(StreamedImage* image) {
+    HttpConnection& http = *image->http;
+    http.close();
+
+    while (image->retriesLeft > 0) {
+        int attempt = IMAGE_RETRIES - --image->retriesLeft;
+        backoff(attempt);
+
+        int offset = image->decoder != nullptr ? (int)image->decoder->consumed() : image->received;
+        ImageError error;
+        ImageFetch result = requestImage(*image->state, http, image->bodyOffset + offset,
+                                         image->bodyBytes - offset, nullptr, error);
+        if (result == ImageFetch::Failed) {
+            if (!error.retryable) {
+                return false;
             }
+            continue;
+        }
+        if (result != ImageFetch::Received || strcmp(http.getETag(), image->etag) != 0) {
+            // The rest of the body belongs to another frame
+            LOG_WARN("Image changed while resuming");
+            http.close();
             return false;
         }
 
-        int sz = http.getResponseSize();
-        Serial.printf("Response size: %d bytes\n", sz);
+        LOG_INFO("Resumed at body offset %d", offset);
+        image->stream = http.getStream();
+        if (image->decoder != nullptr) {
+            image->decoder->resume(image->stream);
+        }
+        return true;
+    }
+    return false;
+}
 
-        if (sz <= 0) {
-            Serial.println("Invalid response size");
-            http.end();
-            if (state.lastRenderSuccess) {
-                showErrorIndicator(ICON_HTTP_ERROR);
-            } else {
-                showError("Invalid response size", 0);
+// Runs on the network task
+static bool readBand(void* context, int band, uint8_t* buffer) {
+    StreamedImage* image = (StreamedImage*)context;
+    size_t bytes = image->layout->bytes(band);
+    size_t filled = 0;
+
+    Telemetry::PhaseTimer timer(Telemetry::PHASE_DOWNLOAD);
+    for (;;) {
+        size_t bytesRead = image->decoder != nullptr
+            ? image->decoder->read(buffer + filled, bytes - filled)
+            : image->stream->readBytes(buffer + filled, bytes - filled);
+        Telemetry::addBytes(bytesRead);
+        filled += bytesRead;
+        image->received += bytesRead;
+        if (filled == bytes) {
+            return true;
+        }
+        LOG_WARN("Stream broke in band %d after %u/%u bytes", band + 1, (unsigned)filled, (unsigned)bytes);
+        if (!resumeStream(image)) {
+            return false;
+        }
+    }
+}
+
+// Runs on the calling task, the only one that touches the display
+static void drainBand(void* context, int band, const uint8_t* buffer) {
+    StreamedImage* image = (StreamedImage*)context;
+    const BandLayout& layout = *image->layout;
+    writeBand(*image->state, buffer, band * layout.rowsPerBand, layout.rows(band));
+    LOG_DEBUG("Band %d/%d complete", band + 1, layout.bandCount);
+}
+
+// Single request for the whole bitmap, read band by band off the same stream
+// The server renders the page once instead of once per chunk
+// With format "rle" the body is PackBits-compressed and expanded per band
+// The next band downloads while the previous one is written to the panel
+// A broken stream is reopened at the byte where it stopped, as long as the
+// server still has the same frame
+static ImageFetch showStreamedImage(AppState& state, const BandLayout& layout, char* etag) {
+    int frameBytes = layout.bytesPerRow * layout.height;
+    bool compressed = state.config.imageFormat == "rle";
+
+    LOG_INFO("Streaming %d bytes in %d bands%s", frameBytes, layout.bandCount,
+             compressed ? " (PackBits)" : "");
+
+    HttpConnection& http = state.http;
+    int bodyOffset = compressed ? 0 : pixelDataOffset(state.config);
+    ImageFetch result = openImageRequest(state, http, bodyOffset, compressed ? 0 : frameBytes, state.rtc.imageEtag);
+    if (result != ImageFetch::Received) {
+        return result;
+    }
+
+    strcpy(etag, http.getETag());
+    WiFiClient* stream = http.getStream();
+
+    PackBitsDecoder decoder;
+    int bodyBytes = frameBytes;
+    if (compressed) {
+        bodyBytes = http.getResponseSize();
+        LOG_DEBUG("Compressed: %d bytes (%d%% of raw)", bodyBytes, bodyBytes * 100 / frameBytes);
+        decoder.begin(stream, bodyBytes);
+    }
+
+    StreamedImage image = {&state, &layout, &http, stream, compressed ? &decoder : nullptr,
+                           bodyOffset, bodyBytes, 0, etag, IMAGE_RETRIES};
+    int bands = BandPipeline::run(state.bandBuffers, state.bandBufferCount, layout.bandCount,
+                                  readBand, drainBand, &image);
+
+    if (bands < layout.bandCount) {
+        // Later bands would only wait out the timeout on the same broken stream
+        LOG_WARN("Stream ended in band %d/%d", bands + 1, layout.bandCount);
+        http.close();
+        reportImageError(state, "Incomplete image data", 0, ICON_HTTP_ERROR);
+        return ImageFetch::Failed;
+    }
+
+    http.end();
+    return ImageFetch::Received;
+}
+
+// Allocate count buffers of bytes each, all or nothing
+static bool allocateBands(AppState& state, int count, size_t bytes, bool psram) {
+    for (int i = 0; i < count; i++) {
+        state.bandBuffers[i] = (uint8_t*)(psram ? ps_malloc(bytes) : malloc(bytes));
+        if (state.bandBuffers[i] == nullptr) {
+            for (int j = 0; j < i; j++) {
+                free(state.bandBuffers[j]);
+                state.bandBuffers[j] = nullptr;
             }
             return false;
         }
+    }
+
+    state.bandBufferCount = count;
+    state.bandBufferBytes = bytes;
+    return true;
+}
+
+bool begin(AppState& state) {
+    constexpr size_t bytesPerRow = DisplayDriver::BYTES_PER_ROW;
+    constexpr int panelHeight = DisplayDriver::HEIGHT;
+    constexpr size_t frameBytes = DisplayDriver::FRAME_BYTES;
+
+    // PSRAM: the whole frame in one buffer, one band (and one request) per image
+    if (psramFound() && ESP.getFreePsram() >= frameBytes && allocateBands(state, 1, frameBytes, true)) {
+        LOG_INFO("Image buffer: full frame, %u bytes in PSRAM", (unsigned)frameBytes);
+        return true;
+    }
+
+    // Internal heap: the fewest bands whose buffers fit next to the reserve
+    for (int chunks = 1; chunks <= MAX_RENDER_CHUNKS; chunks++) {
+        size_t bandBytes = bytesPerRow * ((panelHeight + chunks - 1) / chunks);
+        int buffers = chunks == 1 ? 1 : BAND_BUFFERS;
 
-        WiFiClient* stream = http.getStream();
+        if (bandBytes > ESP.getMaxAllocHeap() ||
+            bandBytes * buffers + HEAP_RESERVE_BYTES > ESP.getFreeHeap()) {
+            continue;
+        }
 
-        if (sz != bytesPerChunk) {
-            Serial.printf("Warning: expected %d bytes, server sent %d bytes\n", bytesPerChunk, sz);
+        if (allocateBands(state, buffers, bandBytes, false)) {
+            LOG_INFO("Image buffers: %d band(s), %d x %u bytes on the heap",
+                     chunks, buffers, (unsigned)bandBytes);
+            return true;
         }
+    }
+
+    LOG_ERROR("Not enough memory for image buffers (%u bytes free)", (unsigned)ESP.getFreeHeap());
+    return false;
+}
+
+// Full images drawn since boot, see imageGeneration()
+static uint32_t imagesShown = 0;
+
+// Layout regions drawn over the full image, each on its own interval
+static bool regionShown[MAX_REGIONS];
+static unsigned long regionShownMs[MAX_REGIONS];
+static char regionEtags[MAX_REGIONS][ETAG_MAX_LEN];
+
+static void resetRegions() {
+    for (int i = 0; i < MAX_REGIONS; i++) {
+        regionShown[i] = false;
+        regionEtags[i][0] = '\0';
+    }
+}
+
+static bool regionDue(const AppState& state, int index, unsigned long now) {
+    unsigned long intervalMs = (unsigned long)state.config.regions[index].intervalSec * 1000;
+    return !regionShown[index] || now - regionShownMs[index] >= intervalMs;
+}
+
+// Fetch one region as epd1 rows and write it into controller RAM and the
+// stored frame band by band; the caller refreshes the window
+// rowsWritten tells a failure after some bands from one that changed nothing
+static ImageFetch fetchRegion(AppState& state, int index, char* etag, int& rowsWritten) {
+    const LayoutRegion& region = state.config.regions[index];
+    int bytesPerRow = region.width / 8;
+    int rowsPerBand = (int)(state.bandBufferBytes / bytesPerRow);
+    rowsWritten = 0;
+    if (rowsPerBand == 0) {
+        return ImageFetch::Failed;
+    }
+
+    // Region fetches are minutes apart, the URL is formatted into a fixed buffer each time
+    static char url[URL_MAX_LEN];
+    ConfigManager::buildRegionUrl(state.config, region, url, sizeof(url));
+
+    HttpConnection& http = state.http;
+    ImageError error;
+    ImageFetch result = requestWithRetries(http, url, bytesPerRow * region.height, regionEtags[index], error);
+    if (result != ImageFetch::Received) {
+        return result;
+    }
 
-        int bytesRead = stream->readBytes(state.bmpBuffer, bytesPerChunk);
-        Serial.printf("Read %d bytes of image data\n", bytesRead);
+    strcpy(etag, http.getETag());
+    if (http.getResponseSize() != bytesPerRow * region.height) {
+        LOG_WARN("Region %d: server sent a different size", index + 1);
+        http.close();
+        return ImageFetch::Failed;
+    }
 
-        if (bytesRead < bytesPerChunk) {
-            Serial.printf("Warning: incomplete read. Expected %d, got %d\n", bytesPerChunk, bytesRead);
+    WiFiClient* stream = http.getStream();
+    uint8_t* buffer = state.bandBuffers[0];
+    for (int row = 0; row < region.height; row += rowsPerBand) {
+        int rows = min(rowsPerBand, region.height - row);
+        Telemetry::start(Telemetry::PHASE_DOWNLOAD);
+        size_t bytesRead = stream->readBytes(buffer, rows * bytesPerRow);
+        Telemetry::stop(Telemetry::PHASE_DOWNLOAD);
+        Telemetry::addBytes(bytesRead);
+        if (bytesRead < (size_t)(rows * bytesPerRow)) {
+            LOG_WARN("Region %d: incomplete data", index + 1);
+            http.close();
+            return ImageFetch::Failed;
         }
 
-        // Invert colors (BMP uses opposite polarity from e-ink display)
-        for (int i = 0; i < bytesRead; i++) {
-            state.bmpBuffer[i] = ~state.bmpBuffer[i];
+        Telemetry::PhaseTimer timer(Telemetry::PHASE_WRITE);
+        writeWindow(buffer, region.x, region.y + row, region.width, rows);
+        rowsWritten += rows;
+    }
+
+    http.end();
+    return ImageFetch::Received;
+}
+
+void writeWindow(const uint8_t* rows, int16_t x, int16_t y, int16_t w, int16_t h) {
+    // Waits for the display task before the frame copy changes, as in writeBand()
+    DisplayDriver::writeImage(rows, x, y, w, h);
+    FrameDiff::patch(rows, x, y, w, h);
+}
+
+void refreshWindow(AppState& state, int16_t x, int16_t y, int16_t w, int16_t h) {
+    Telemetry::PhaseTimer timer(Telemetry::PHASE_REFRESH);
+    if (partialAllowed(state.config)) {
+        DisplayDriver::refresh(x, y, w, h);
+        partialsSinceFull++;
+    } else {
+        LOG_INFO("Full refresh to clear ghosting");
+        fullRefresh();
+    }
+    DisplayDriver::writeImageAgain(FrameDiff::frame(), 0, 0, state.config.displayWidth, state.config.displayHeight);
+}
+
+bool windowsReady() {
+    // Partial windows need the controller's previous-image RAM to match the panel
+    return FrameDiff::enabled() && FrameDiff::hasPrevious();
+}
+
+uint32_t imageGeneration() {
+    return imagesShown;
+}
+
+void setRefreshMode(RefreshMode mode) {
+    refreshMode = mode;
+}
+
+int showDueRegions(AppState& state) {
+    if (state.config.regionCount == 0 || !windowsReady()) {
+        return 0;
+    }
+
+    int shown = 0;
+    for (int i = 0; i < state.config.regionCount; i++) {
+        unsigned long now = millis();
+        if (!regionDue(state, i, now)) {
+            continue;
         }
 
-        int yPos = chunk * rowsPerChunk;
+        const LayoutRegion& region = state.config.regions[i];
+        LOG_DEBUG("Region %d/%d due: %s", i + 1, state.config.regionCount, region.templateName.c_str());
+
+        char etag[ETAG_MAX_LEN];
+        int rowsWritten;
+        ImageFetch result = fetchRegion(state, i, etag, rowsWritten);
+        regionShown[i] = true;
+        regionShownMs[i] = now;
+
+        if (result == ImageFetch::Failed) {
+            regionEtags[i][0] = '\0';
+            if (rowsWritten > 0) {
+                // Controller RAM and the stored frame hold part of the region; forget the
+                // image ETag so the next full image is downloaded and committed, not a 304
+                FrameDiff::invalidate();
+                state.rtc.imageEtag[0] = '\0';
+            }
+            return shown;
+        }
+        if (result == ImageFetch::NotModified) {
+            continue;
+        }
 
-        do {
-            DisplayDriver::drawBitmap(0, yPos, state.bmpBuffer, state.config.displayWidth, rowsPerChunk, GxEPD_BLACK);
-        } while (DisplayDriver::nextPage());
+        refreshWindow(state, region.x, region.y, region.width, region.height);
 
-        Serial.printf("Chunk %d/%d complete\n", chunk + 1, RENDER_CHUNKS);
-        http.end();
+        strcpy(regionEtags[i], etag);
+        shown++;
+    }
+    return shown;
+}
+
+unsigned long msUntilNextRegion(const AppState& state) {
+    // Same gate as showDueRegions(), which skips due regions until the next full image
+    if (state.config.regionCount == 0 || !windowsReady()) {
+        return ULONG_MAX;
+    }
+
+    unsigned long now = millis();
+    unsigned long next = ULONG_MAX;
+    for (int i = 0; i < state.config.regionCount; i++) {
+        if (regionDue(state, i, now)) {
+            return 0;
+        }
+        unsigned long intervalMs = (unsigned long)state.config.regions[i].intervalSec * 1000;
+        next = min(next, intervalMs - (now - regionShownMs[i]));
     }
+    return next;
+}
+
+bool showRemoteImage(AppState& state) {
+    BandLayout layout;
+    if (!planBands(state, layout)) {
+        reportImageError(state, "Unsupported image size", 0, ICON_SERVER_ERROR);
+        return false;
+    }
+
+    LOG_INFO("Starting incremental render: %d bands of %d rows (%d bytes) each",
+             layout.bandCount, layout.rowsPerBand, layout.rowsPerBand * layout.bytesPerRow);
+
+    // Compressed bodies cannot be sliced at row boundaries, they always stream
+    bool stream = state.config.imageStream || state.config.imageFormat == "rle";
+
+    char etag[ETAG_MAX_LEN] = "";
+    FrameDiff::beginFrame();
+    recordFrame = true;
+    ImageFetch result = stream
+        ? showStreamedImage(state, layout, etag)
+        : showChunkedImage(state, layout, etag);
+    recordFrame = false;
+
+    if (result == ImageFetch::Failed) {
+        return false;
+    }
+
+    if (result == ImageFetch::NotModified) {
+        FrameStore::discard();
+        LOG_INFO("Image unchanged (ETag %s), skipping panel refresh", state.rtc.imageEtag);
+        state.rtc.lastRenderSuccess = true;
+        return true;
+    }
+
+    // All bands are in controller RAM, one refresh pass shows the frame
+    Telemetry::start(Telemetry::PHASE_REFRESH);
+    refreshFrame(state);
+    Telemetry::stop(Telemetry::PHASE_REFRESH);
+
+    // Remember what is on the panel (getETag() already dropped oversized tags)
+    strcpy(state.rtc.imageEtag, etag);
+
+    // Only a frame that reached the panel replaces the one in flash
+    FrameStore::commit(state.rtc.imageEtag);
+
+    // The full image covers the regions and overlays too, draw them again over it
+    resetRegions();
+    imagesShown++;
+
+    LOG_INFO("Image display complete!");
+    state.rtc.lastRenderSuccess = true;
+    return true;
+}
+
+bool showCachedFrame(AppState& state) {
+    BandLayout layout;
+    char etag[ETAG_MAX_LEN];
+    if (!planBands(state, layout) ||
+        !FrameStore::open(state.config.displayWidth, state.config.displayHeight, etag, sizeof(etag))) {
+        return false;
+    }
+
+    LOG_INFO("Showing cached frame from flash (ETag %s)", etag[0] ? etag : "none");
+    uint8_t* buffer = state.bandBuffers[0];
+    FrameDiff::beginFrame();
+    for (int band = 0; band < layout.bandCount; band++) {
+        size_t bytes = layout.bytes(band);
+        if (FrameStore::read(buffer, bytes) != bytes) {
+            LOG_WARN("Cached frame is truncated");
+            FrameStore::close();
+            FrameDiff::invalidate();
+            return false;
+        }
+        writeBand(state, buffer, band * layout.rowsPerBand, layout.rows(band));
+    }
+    FrameStore::close();
+
+    refreshFrame(state);
 
-    Serial.println("Image display complete!");
-    state.lastRenderSuccess = true;
+    // The panel shows the frame with this tag, so an unchanged server image answers 304
+    strcpy(state.rtc.imageEtag, etag);
+    resetRegions();
+    imagesShown++;
+    state.rtc.lastRenderSuccess = true;
     return true;
 }
 
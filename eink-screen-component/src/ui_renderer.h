@@ -8,6 +8,11 @@
 struct AppState;
 
 namespace UiRenderer {
+    // Size the image band buffers from free memory; call once at boot
+    // PSRAM boards get one full-frame buffer, others the fewest bands that fit
+    // Returns false if no buffer could be allocated
+    bool begin(AppState& state);
+
     // Display error screen with optional icon
     // icon can be ICON_WIFI_ERROR, ICON_SERVER_ERROR, ICON_HTTP_ERROR, or nullptr
     void showError(const char* message, int errorCode = 0, const uint8_t* icon = nullptr);
@@ -16,9 +21,50 @@ namespace UiRenderer {
     // Use when previous image was successfully rendered to avoid clearing the screen
     void showErrorIndicator(const uint8_t* icon = nullptr);
 
-    // Display image from remote server using chunked loading
+    // Report that WiFi could not be reached: corner indicator over a good image,
+    // full error screen otherwise
+    void showWifiError(AppState& state);
+
+    // Display image from remote server, band by band
+    // Fails if the server-declared size does not fit the panel
     // Returns true on success
     bool showRemoteImage(AppState& state);
+
+    // Draw the last good frame kept in flash, e.g. at boot before WiFi is up
+    // Restores its ETag so an unchanged server image is not fetched again
+    // Returns false if no frame of the configured size is stored
+    bool showCachedFrame(AppState& state);
+
+    // Fetch the layout regions whose interval is up and refresh each in its
+    // own partial window over the full image (needs frame diffing)
+    // Returns the number of regions redrawn
+    int showDueRegions(AppState& state);
+
+    // Milliseconds until the next layout region is due, ULONG_MAX without regions
+    unsigned long msUntilNextRegion(const AppState& state);
+
+    // True once windows can be drawn over the image: frame diffing is on and
+    // the controller's previous-image RAM matches the panel
+    bool windowsReady();
+
+    // Write a byte-aligned window of panel rows (w / 8 bytes each, 1 = white)
+    // into controller RAM and the stored frame; refreshWindow() then shows it
+    void writeWindow(const uint8_t* rows, int16_t x, int16_t y, int16_t w, int16_t h);
+
+    // Partially refresh a window written with writeWindow(), or run a full
+    // refresh when the ghosting budget is used up
+    void refreshWindow(AppState& state, int16_t x, int16_t y, int16_t w, int16_t h);
+
+    // Counts full images drawn; layers over the image redraw when it changes
+    uint32_t imageGeneration();
+
+    // How showRemoteImage() puts a new frame on the panel
+    enum RefreshMode {
+        REFRESH_AUTO,    // Changed regions, fast or full waveform as the frame diff decides
+        REFRESH_WINDOW,  // One fast partial window over the whole frame (bench)
+        REFRESH_NONE     // Controller RAM writes only, no waveform (bench)
+    };
+    void setRefreshMode(RefreshMode mode);
 }
 
 #endif
@@ -1,31 +1,108 @@
 #include "wifi_manager.h"
+#include "logging.h"
 #include "secrets.h"
+#include "telemetry.h"
 #include <WiFi.h>
 
 namespace WifiManager {
 
-void setup(WiFiMulti& wifiMulti) {
-    Serial.printf("Connecting to WiFi SSID: %s\n", WIFI_SSID);
-    wifiMulti.addAP(WIFI_SSID, WIFI_PASSWORD);
+static bool waitForConnection(uint32_t timeoutMs) {
+    uint32_t start = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+        if (millis() - start >= timeoutMs) {
+            return false;
+        }
+        delay(10);
+    }
+    return true;
+}
+
+// Join the known BSSID/channel with the previous IP: no scan, no DHCP
+static bool fastConnect(WifiLease& lease) {
+    if (!lease.valid) {
+        return false;
+    }
+    if (lease.reuseCount >= WIFI_LEASE_MAX_REUSE) {
+        // Renew through DHCP; a stay-awake build still has the static IP configured
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+        return false;
+    }
+
+    uint32_t start = millis();
+    WiFi.mode(WIFI_STA);
+    WiFi.config(IPAddress(lease.ip), IPAddress(lease.gateway), IPAddress(lease.subnet), IPAddress(lease.dns));
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD, lease.channel, lease.bssid);
+
+    if (!waitForConnection(WIFI_FAST_CONNECT_TIMEOUT_MS)) {
+        LOG_WARN("Fast connect failed, scanning");
+        lease.valid = false;
+        WiFi.disconnect();
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);  // Back to DHCP
+        return false;
+    }
+
+    lease.reuseCount++;
+    LOG_INFO("Fast connect on channel %d in %u ms", (int)lease.channel, (unsigned)(millis() - start));
+    return true;
+}
+
+static void storeLease(WifiLease& lease) {
+    memcpy(lease.bssid, WiFi.BSSID(), sizeof(lease.bssid));
+    lease.channel = WiFi.channel();
+    lease.ip = WiFi.localIP();
+    lease.gateway = WiFi.gatewayIP();
+    lease.subnet = WiFi.subnetMask();
+    lease.dns = WiFi.dnsIP();
+    lease.reuseCount = 0;
+    lease.valid = true;
+}
 
+static bool connect(WiFiMulti& wifiMulti, WifiLease& lease) {
+    Telemetry::PhaseTimer timer(Telemetry::PHASE_WIFI);
+
+    if (fastConnect(lease)) {
+        return true;
+    }
+
+    // Full scan and DHCP, bounded so a missing AP cannot hang the device
+    uint32_t start = millis();
     while (wifiMulti.run() != WL_CONNECTED) {
+        if (millis() - start >= WIFI_CONNECT_TIMEOUT_MS) {
+            LOG_ERROR("WiFi connect timed out after %u ms (status %d)",
+                      (unsigned)(millis() - start), (int)WiFi.status());
+            return false;
+        }
         delay(100);
-        Serial.println((char)WiFi.status());
     }
 
-    Serial.println("Connected to WiFi!");
+    storeLease(lease);
+    LOG_INFO("Connected in %u ms, IP %s", (unsigned)(millis() - start), WiFi.localIP().toString().c_str());
+    return true;
 }
 
-bool ensureConnected(WiFiMulti& wifiMulti) {
+bool setup(WiFiMulti& wifiMulti, WifiLease& lease) {
+    LOG_INFO("Connecting to WiFi SSID: %s", WIFI_SSID);
+    wifiMulti.addAP(WIFI_SSID, WIFI_PASSWORD);
+
+    if (!connect(wifiMulti, lease)) {
+        return false;
+    }
+
+    LOG_INFO("Connected to WiFi!");
+    return true;
+}
+
+bool ensureConnected(WiFiMulti& wifiMulti, WifiLease& lease) {
     if (WiFi.status() == WL_CONNECTED) {
         return true;
     }
 
-    Serial.println("WiFi disconnected. Reconnecting...");
-    while (wifiMulti.run() != WL_CONNECTED) {
-        delay(100);
+    LOG_WARN("WiFi disconnected. Reconnecting...");
+    if (!connect(wifiMulti, lease)) {
+        return false;
     }
-    Serial.println("WiFi reconnected");
+
+    LOG_INFO("WiFi reconnected");
     return true;
 }
 
@@ -3,14 +3,37 @@
 
 #include <WiFiMulti.h>
 
+// Give up on the cached access point after this long and scan instead
+constexpr uint32_t WIFI_FAST_CONNECT_TIMEOUT_MS = 1500;
+
+// Give up on connecting altogether after this long
+constexpr uint32_t WIFI_CONNECT_TIMEOUT_MS = 15000;
+
+// Renew the lease over DHCP after this many fast connects (~8h at a 5 min refresh)
+constexpr uint16_t WIFI_LEASE_MAX_REUSE = 100;
+
+// Last successful association, reused to connect without a scan or DHCP
+// Plain data so it can live in RTC memory across deep sleep
+struct WifiLease {
+    bool valid;
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    uint16_t reuseCount;  // Fast connects since the lease came from DHCP
+};
+
 namespace WifiManager {
     // Initialize WiFi with credentials from secrets.h
-    // Blocks until connected
-    void setup(WiFiMulti& wifiMulti);
+    // Connects straight to the leased access point when possible, scans otherwise
+    // Returns false if not connected within WIFI_CONNECT_TIMEOUT_MS
+    bool setup(WiFiMulti& wifiMulti, WifiLease& lease);
 
-    // Check connection and reconnect if needed
+    // Check connection and reconnect if needed (same strategy and timeout as setup)
     // Returns true if connected
-    bool ensureConnected(WiFiMulti& wifiMulti);
+    bool ensureConnected(WiFiMulti& wifiMulti, WifiLease& lease);
 
     // Check if currently connected
     bool isConnected();
@@ -0,0 +1,164 @@
+#ifndef FAKE_ARDUINO_H
+#define FAKE_ARDUINO_H
+
+// Host stand-in for the parts of the Arduino-ESP32 core used by the render path
+// Only for [env:native]; behaviour is the minimum the firmware relies on
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#define PROGMEM
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
+
+using std::max;
+using std::min;
+
+inline uint8_t pgm_read_byte(const void* p) {
+    return *(const uint8_t*)p;
+}
+
+// delay() advances a virtual clock instead of sleeping, so retry backoff
+// costs nothing in tests; micros() includes the time skipped this way
+inline std::atomic<unsigned long> fakeDelayedUs{0};
+
+inline unsigned long micros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count() + fakeDelayedUs;
+}
+
+inline unsigned long millis() {
+    return micros() / 1000;
+}
+
+inline void delay(unsigned long ms) {
+    fakeDelayedUs += ms * 1000;
+}
+
+inline long random(long max) {
+    return max > 0 ? rand() % max : 0;
+}
+
+class String {
+public:
+    String() {}
+    String(const char* s) : value(s != nullptr ? s : "") {}
+    String(const std::string& s) : value(s) {}
+    explicit String(int n) : value(std::to_string(n)) {}
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.size(); }
+    bool isEmpty() const { return value.empty(); }
+    bool equals(const String& other) const { return value == other.value; }
+    int indexOf(const char* s, unsigned int from = 0) const {
+        size_t pos = value.find(s, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t pos = value.find(c, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    String substring(unsigned int from) const { return String(value.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const { return String(value.substr(from, to - from)); }
+    int toInt() const { return atoi(value.c_str()); }
+
+    String operator+(const String& other) const { return String(value + other.value); }
+    String operator+(const char* other) const { return String(value + other); }
+    String& operator+=(const String& other) { value += other.value; return *this; }
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator==(const char* other) const { return value == other; }
+    bool operator!=(const String& other) const { return value != other.value; }
+    bool operator!=(const char* other) const { return value != other; }
+
+private:
+    std::string value;
+};
+
+inline String operator+(const char* a, const String& b) {
+    return String(std::string(a) + b.c_str());
+}
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) { return 1; }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual size_t readBytes(uint8_t* buffer, size_t length) {
+        size_t count = 0;
+        while (count < length) {
+            int c = read();
+            if (c < 0) {
+                break;
+            }
+            buffer[count++] = (uint8_t)c;
+        }
+        return count;
+    }
+    size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+    void setTimeout(unsigned long) {}
+};
+
+// Output is dropped unless echo is set, so benchmarks do not time the console
+class FakeSerial : public Stream {
+public:
+    bool echo = false;
+
+    void begin(unsigned long) {}
+    void flush() {}
+    size_t printf(const char* format, ...) {
+        if (!echo) {
+            return 0;
+        }
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        return n < 0 ? 0 : (size_t)n;
+    }
+    size_t println(const char* s = "") { return echo ? (size_t)::printf("%s\n", s) : 0; }
+    size_t println(const String& s) { return println(s.c_str()); }
+    size_t print(const char* s) { return echo ? (size_t)::printf("%s", s) : 0; }
+    size_t write(const uint8_t* buffer, size_t size) { return echo ? fwrite(buffer, 1, size, stdout) : 0; }
+    using Print::write;
+};
+
+inline FakeSerial Serial;
+
+// Memory figures reported to UiRenderer::begin(); tests may change them
+struct FakeEsp {
+    uint32_t freeHeap = 200000;
+    uint32_t maxAllocHeap = 110000;
+    uint32_t minFreeHeap = 150000;
+    uint32_t freePsram = 0;
+
+    uint32_t getFreeHeap() const { return freeHeap; }
+    uint32_t getMaxAllocHeap() const { return maxAllocHeap; }
+    uint32_t getMinFreeHeap() const { return minFreeHeap; }
+    uint32_t getFreePsram() const { return freePsram; }
+};
+
+inline FakeEsp ESP;
+
+inline bool psramFound() {
+    return ESP.freePsram > 0;
+}
+
+inline void* ps_malloc(size_t size) {
+    return malloc(size);
+}
+
+#endif
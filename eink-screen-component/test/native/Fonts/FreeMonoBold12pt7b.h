@@ -0,0 +1,8 @@
+#ifndef FAKE_FREE_MONO_BOLD_12PT7B_H
+#define FAKE_FREE_MONO_BOLD_12PT7B_H
+
+#include <GxEPD2_BW.h>
+
+const GFXfont FreeMonoBold12pt7b = {12};
+
+#endif
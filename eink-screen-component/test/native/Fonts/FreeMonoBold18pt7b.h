@@ -0,0 +1,8 @@
+#ifndef FAKE_FREE_MONO_BOLD_18PT7B_H
+#define FAKE_FREE_MONO_BOLD_18PT7B_H
+
+#include <GxEPD2_BW.h>
+
+const GFXfont FreeMonoBold18pt7b = {18};
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef FAKE_FREE_MONO_BOLD_24PT7B_H
+#define FAKE_FREE_MONO_BOLD_24PT7B_H
+
+#include <GxEPD2_BW.h>
+
+const GFXfont FreeMonoBold24pt7b = {24};
+
+#endif
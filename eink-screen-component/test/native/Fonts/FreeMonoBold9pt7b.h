@@ -0,0 +1,8 @@
+#ifndef FAKE_FREE_MONO_BOLD_9PT7B_H
+#define FAKE_FREE_MONO_BOLD_9PT7B_H
+
+#include <GxEPD2_BW.h>
+
+const GFXfont FreeMonoBold9pt7b = {9};
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef FAKE_GXEPD2_BW_H
+#define FAKE_GXEPD2_BW_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <thread>
+
+// Host stand-in for GxEPD2: keeps controller RAM and the drawing buffer in memory
+// and counts the calls the render path makes, so tests can check the output and
+// benchmarks can report the work done
+
+#define GxEPD_WHITE 0xFFFF
+#define GxEPD_BLACK 0x0000
+
+struct GFXfont {
+    int size;
+};
+
+struct FakePanel {
+    static constexpr int WIDTH = 800;
+    static constexpr int HEIGHT = 480;
+    static constexpr int BYTES_PER_ROW = WIDTH / 8;
+    static constexpr int FRAME_BYTES = BYTES_PER_ROW * HEIGHT;
+
+    uint8_t ram[FRAME_BYTES];          // Controller "new image" RAM, 1 = white
+    uint8_t previousRam[FRAME_BYTES];  // Controller "previous image" RAM
+    uint8_t canvas[FRAME_BYTES];       // GFX drawing buffer, 1 = white
+
+    uint32_t ramBytesWritten = 0;
+    uint32_t fullRefreshes = 0;
+    uint32_t partialRefreshes = 0;
+    uint32_t drawCalls = 0;      // fillRect/drawPixel calls
+    uint32_t pixelsDrawn = 0;
+
+    // While set, refreshes block as if the panel held BUSY (not cleared by reset())
+    std::atomic<bool> holdRefresh{false};
+
+    void reset() {
+        memset(ram, 0xFF, sizeof(ram));
+        memset(previousRam, 0xFF, sizeof(previousRam));
+        memset(canvas, 0xFF, sizeof(canvas));
+        ramBytesWritten = 0;
+        fullRefreshes = 0;
+        partialRefreshes = 0;
+        drawCalls = 0;
+        pixelsDrawn = 0;
+    }
+
+    // Copy byte-aligned rows into controller RAM
+    static void writeRows(uint8_t* target, const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h) {
+        int16_t rowBytes = (w + 7) / 8;
+        for (int16_t row = 0; row < h && y + row < HEIGHT; row++) {
+            memcpy(target + (y + row) * BYTES_PER_ROW + x / 8, bitmap + row * rowBytes, rowBytes);
+        }
+    }
+
+    void setPixel(int16_t x, int16_t y, uint16_t color) {
+        if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) {
+            return;
+        }
+        uint8_t& b = canvas[y * BYTES_PER_ROW + x / 8];
+        uint8_t mask = 0x80 >> (x & 7);
+        b = color == GxEPD_WHITE ? (b | mask) : (b & ~mask);
+        pixelsDrawn++;
+    }
+
+    bool canvasPixel(int16_t x, int16_t y) const {
+        return !(canvas[y * BYTES_PER_ROW + x / 8] & (0x80 >> (x & 7)));
+    }
+};
+
+inline FakePanel fakePanel;
+
+class GxEPD2_EPD {
+public:
+    void writeImageForFullRefresh(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h,
+                                  bool = false, bool = false, bool = false) {
+        FakePanel::writeRows(fakePanel.ram, bitmap, x, y, w, h);
+        FakePanel::writeRows(fakePanel.previousRam, bitmap, x, y, w, h);
+        fakePanel.ramBytesWritten += 2 * h * ((w + 7) / 8);
+    }
+
+    void writeImageAgain(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h,
+                         bool = false, bool = false, bool = false) {
+        FakePanel::writeRows(fakePanel.previousRam, bitmap, x, y, w, h);
+        fakePanel.ramBytesWritten += h * ((w + 7) / 8);
+    }
+
+    void hibernate() {}
+};
+
+template <typename Driver, int PageHeight>
+class GxEPD2_BW {
+public:
+    Driver epd2;
+
+    explicit GxEPD2_BW(Driver driver) : epd2(driver) {}
+
+    void init(uint32_t, bool, uint16_t, bool) { fakePanel.reset(); }
+    void hibernate() {}
+    int16_t width() const { return Driver::WIDTH; }
+    int16_t height() const { return Driver::HEIGHT; }
+    void setRotation(uint8_t) {}
+    void setFullWindow() {}
+    void setPartialWindow(uint16_t, uint16_t, uint16_t, uint16_t) {}
+    void firstPage() {}
+    bool nextPage() { return false; }
+    void fillScreen(uint16_t color) { memset(fakePanel.canvas, color == GxEPD_WHITE ? 0xFF : 0x00, FakePanel::FRAME_BYTES); }
+    void setTextColor(uint16_t) {}
+    void setFont(const GFXfont*) {}
+    void setCursor(int16_t, int16_t) {}
+    void getTextBounds(const char* s, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+        *x1 = x;
+        *y1 = y;
+        *w = strlen(s) * 12;
+        *h = 16;
+    }
+    void print(const char*) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) {
+        fakePanel.drawCalls++;
+        fakePanel.setPixel(x, y, color);
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        fakePanel.drawCalls++;
+        for (int16_t j = y; j < y + h; j++) {
+            for (int16_t i = x; i < x + w; i++) {
+                fakePanel.setPixel(i, j, color);
+            }
+        }
+    }
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        fillRect(x, y, w, 1, color);
+        fillRect(x, y + h - 1, w, 1, color);
+        fillRect(x, y, 1, h, color);
+        fillRect(x + w - 1, y, 1, h, color);
+    }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t, int16_t, uint16_t color) { drawPixel(x0, y0, color); }
+    void drawCircle(int16_t x, int16_t y, int16_t, uint16_t color) { drawPixel(x, y, color); }
+    void fillCircle(int16_t x, int16_t y, int16_t, uint16_t color) { drawPixel(x, y, color); }
+    void drawBitmap(int16_t, int16_t, const uint8_t*, int16_t, int16_t, uint16_t) {}
+
+    void writeImage(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h,
+                    bool = false, bool = false, bool = false) {
+        FakePanel::writeRows(fakePanel.ram, bitmap, x, y, w, h);
+        fakePanel.ramBytesWritten += h * ((w + 7) / 8);
+    }
+
+    void refresh(bool partialUpdateMode = false) {
+        waitWhileBusy();
+        if (partialUpdateMode) {
+            fakePanel.partialRefreshes++;
+        } else {
+            fakePanel.fullRefreshes++;
+        }
+    }
+
+    void refresh(int16_t, int16_t, int16_t, int16_t) {
+        waitWhileBusy();
+        fakePanel.partialRefreshes++;
+    }
+
+    static void waitWhileBusy() {
+        while (fakePanel.holdRefresh) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef FAKE_HTTP_CLIENT_H
+#define FAKE_HTTP_CLIENT_H
+
+// HttpConnection is replaced by a fake in the native tests; only the type is needed
+class HTTPClient {};
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef FAKE_SPI_H
+#define FAKE_SPI_H
+
+struct FakeSpi {
+    void begin(int, int, int, int) {}
+};
+
+inline FakeSpi SPI;
+
+#endif
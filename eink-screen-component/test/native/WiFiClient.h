@@ -0,0 +1,40 @@
+#ifndef FAKE_WIFI_CLIENT_H
+#define FAKE_WIFI_CLIENT_H
+
+#include <Arduino.h>
+
+// Replays a response body; readBytes returns short once it runs out
+class WiFiClient : public Stream {
+public:
+    void replay(const uint8_t* body, size_t length) {
+        data = body;
+        remaining = length;
+    }
+
+    int available() override { return (int)remaining; }
+
+    int read() override {
+        if (remaining == 0) {
+            return -1;
+        }
+        remaining--;
+        return *data++;
+    }
+
+    size_t readBytes(uint8_t* buffer, size_t length) override {
+        size_t n = min(length, remaining);
+        memcpy(buffer, data, n);
+        data += n;
+        remaining -= n;
+        return n;
+    }
+
+    bool connected() { return remaining > 0; }
+    void stop() { remaining = 0; }
+
+private:
+    const uint8_t* data = nullptr;
+    size_t remaining = 0;
+};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef FAKE_WIFI_MULTI_H
+#define FAKE_WIFI_MULTI_H
+
+#include <Arduino.h>
+
+#define WL_CONNECTED 3
+
+class WiFiMulti {
+public:
+    bool addAP(const char*, const char* = nullptr) { return true; }
+    uint8_t run(uint32_t = 5000) { return WL_CONNECTED; }
+};
+
+#endif
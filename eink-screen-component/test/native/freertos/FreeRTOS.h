@@ -0,0 +1,97 @@
+#ifndef FAKE_FREERTOS_H
+#define FAKE_FREERTOS_H
+
+// Host stand-in for the FreeRTOS calls used by BandPipeline
+// Tasks are pthreads and queues are mutex/condvar ring buffers, so the
+// pipeline really runs on two threads in the native tests
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+typedef uint32_t TickType_t;
+typedef unsigned int UBaseType_t;
+typedef int BaseType_t;
+typedef void (*TaskFunction_t)(void*);
+typedef void* TaskHandle_t;
+
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+
+// Kernel objects created, each one a heap allocation on the device
+inline std::atomic<uint32_t> fakeRtosAllocations{0};
+
+struct FakeQueue {
+    size_t itemSize;
+    size_t capacity;
+    uint8_t* storage;
+    size_t head = 0;
+    size_t count = 0;
+    std::mutex lock;
+    std::condition_variable changed;
+
+    FakeQueue(size_t capacity, size_t itemSize)
+        : itemSize(itemSize), capacity(capacity), storage((uint8_t*)malloc(capacity * itemSize + 1)) {}
+    ~FakeQueue() { free(storage); }
+
+    // ticks is only honoured as "wait" (non-zero) or "poll" (zero)
+    BaseType_t send(const void* item, TickType_t ticks) {
+        std::unique_lock<std::mutex> guard(lock);
+        if (count == capacity) {
+            if (ticks == 0) {
+                return pdFALSE;
+            }
+            changed.wait(guard, [this] { return count < capacity; });
+        }
+        if (itemSize > 0) {
+            memcpy(storage + ((head + count) % capacity) * itemSize, item, itemSize);
+        }
+        count++;
+        changed.notify_all();
+        return pdTRUE;
+    }
+
+    void reset() {
+        std::unique_lock<std::mutex> guard(lock);
+        head = 0;
+        count = 0;
+        changed.notify_all();
+    }
+
+    BaseType_t receive(void* item, TickType_t ticks) {
+        std::unique_lock<std::mutex> guard(lock);
+        if (count == 0) {
+            if (ticks == 0) {
+                return pdFALSE;
+            }
+            changed.wait(guard, [this] { return count > 0; });
+        }
+        if (itemSize > 0) {
+            memcpy(item, storage + head * itemSize, itemSize);
+        }
+        head = (head + 1) % capacity;
+        count--;
+        changed.notify_all();
+        return pdTRUE;
+    }
+};
+
+// Placement-constructed in malloc'd memory so operator new counts stay the firmware's own
+inline FakeQueue* fakeQueueCreate(size_t capacity, size_t itemSize) {
+    void* memory = malloc(sizeof(FakeQueue));
+    fakeRtosAllocations++;
+    return memory != nullptr ? new (memory) FakeQueue(capacity, itemSize) : nullptr;
+}
+
+inline void fakeQueueDelete(FakeQueue* queue) {
+    queue->~FakeQueue();
+    free(queue);
+}
+
+#endif
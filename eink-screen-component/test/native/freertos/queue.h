@@ -0,0 +1,29 @@
+#ifndef FAKE_FREERTOS_QUEUE_H
+#define FAKE_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef FakeQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    return fakeQueueCreate(length, itemSize);
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    return queue->send(item, ticks);
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    return queue->receive(item, ticks);
+}
+
+inline BaseType_t xQueueReset(QueueHandle_t queue) {
+    queue->reset();
+    return pdPASS;
+}
+
+inline void vQueueDelete(QueueHandle_t queue) {
+    fakeQueueDelete(queue);
+}
+
+#endif
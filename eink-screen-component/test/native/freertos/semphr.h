@@ -0,0 +1,27 @@
+#ifndef FAKE_FREERTOS_SEMPHR_H
+#define FAKE_FREERTOS_SEMPHR_H
+
+#include "queue.h"
+
+// A binary semaphore is a one-slot queue of empty items, as in FreeRTOS
+typedef FakeQueue* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return fakeQueueCreate(1, 0);
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    uint8_t token = 0;
+    return semaphore->send(&token, 0);
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    uint8_t token;
+    return semaphore->receive(&token, ticks);
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    fakeQueueDelete(semaphore);
+}
+
+#endif
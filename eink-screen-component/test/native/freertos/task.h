@@ -0,0 +1,46 @@
+#ifndef FAKE_FREERTOS_TASK_H
+#define FAKE_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+#include <pthread.h>
+
+struct FakeTaskStart {
+    TaskFunction_t task;
+    void* param;
+};
+
+inline void* fakeTaskEntry(void* arg) {
+    FakeTaskStart start = *(FakeTaskStart*)arg;
+    free(arg);
+    start.task(start.param);
+    return nullptr;
+}
+
+// Core and priority are ignored; the thread is detached like a FreeRTOS task
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char*, uint32_t, void* param,
+                                          UBaseType_t, TaskHandle_t*, BaseType_t) {
+    FakeTaskStart* start = (FakeTaskStart*)malloc(sizeof(FakeTaskStart));
+    if (start == nullptr) {
+        return pdFAIL;
+    }
+    *start = {task, param};
+    fakeRtosAllocations++;
+
+    pthread_t thread;
+    if (pthread_create(&thread, nullptr, fakeTaskEntry, start) != 0) {
+        free(start);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    return pdPASS;
+}
+
+// Only self-deletion is used; the thread ends when the task function returns
+inline void vTaskDelete(TaskHandle_t) {}
+
+// Threads have no FreeRTOS stack to measure; reports the whole stack as unused
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+    return 8192;
+}
+
+#endif
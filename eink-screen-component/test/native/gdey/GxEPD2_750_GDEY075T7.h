@@ -0,0 +1,14 @@
+#ifndef FAKE_GXEPD2_750_GDEY075T7_H
+#define FAKE_GXEPD2_750_GDEY075T7_H
+
+#include <GxEPD2_BW.h>
+
+class GxEPD2_750_GDEY075T7 : public GxEPD2_EPD {
+public:
+    static const uint16_t WIDTH = FakePanel::WIDTH;
+    static const uint16_t HEIGHT = FakePanel::HEIGHT;
+
+    GxEPD2_750_GDEY075T7(int16_t, int16_t, int16_t, int16_t) {}
+};
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef SECRETS_H
+#define SECRETS_H
+
+// Placeholder credentials for host builds
+#define WIFI_SSID "native"
+#define WIFI_PASSWORD "native"
+
+#endif
@@ -0,0 +1,197 @@
+// Fake network and flash backends for [env:native]
+// http_client.cpp, config_manager.cpp and telemetry.cpp need the WiFi stack
+// and ArduinoJson, frame_store.cpp needs LittleFS; the render path only needs
+// what they return
+
+#include "fake_server.h"
+#include "config_manager.h"
+#include "http_client.h"
+#include "telemetry.h"
+#include "frame_store.h"
+
+FakeServer fakeServer;
+FakeFlash fakeFlash;
+
+static size_t responseSize = 0;
+
+// Value of "&name=" in the query, -1 if absent
+// Allocates nothing, like the firmware's request path it stands in for
+static long queryValue(const char* url, const char* key) {
+    const char* pos = strstr(url, key);
+    return pos == nullptr ? -1 : atol(pos + strlen(key));
+}
+
+bool HttpConnection::begin(const char* requestUrl, int timeout) {
+    if (!fakeServer.reachable || strlen(requestUrl) >= sizeof(url)) {
+        return false;
+    }
+    if (requestUrl != url) {
+        strcpy(url, requestUrl);
+    }
+    timeoutMs = timeout;
+    ifNoneMatch[0] = '\0';
+    return true;
+}
+
+void HttpConnection::setIfNoneMatch(const char* value) {
+    snprintf(ifNoneMatch, sizeof(ifNoneMatch), "%s", value);
+}
+
+int HttpConnection::get() {
+    fakeServer.requests++;
+    fakeServer.lastUrl = url;
+
+    if (!fakeServer.etag.empty() && fakeServer.etag == ifNoneMatch) {
+        fakeServer.notModified++;
+        responseSize = 0;
+        wifiClient.replay(nullptr, 0);
+        return 304;
+    }
+
+    size_t offset = 0;
+    size_t length = fakeServer.body.size();
+    long limit = queryValue(url, "&limit=");
+    if (limit > 0) {
+        offset = min((size_t)queryValue(url, "&offset="), length);
+        length = min((size_t)limit, length - offset);
+    }
+
+    responseSize = length;
+    if (fakeServer.dropAfter > 0) {
+        length = min(length, fakeServer.dropAfter);
+        fakeServer.dropAfter = 0;
+    }
+    wifiClient.replay(fakeServer.body.data() + offset, length);
+    return fakeServer.status;
+}
+
+int HttpConnection::post(const char*, const uint8_t*, size_t) {
+    return 204;
+}
+
+bool HttpConnection::reopen() {
+    return fakeServer.reachable;
+}
+
+const char* HttpConnection::getETag() {
+    snprintf(etag, sizeof(etag), "%s", fakeServer.etag.size() < sizeof(etag) ? fakeServer.etag.c_str() : "");
+    return etag;
+}
+
+void HttpConnection::discardBody() {
+    wifiClient.stop();
+}
+
+int HttpConnection::getResponseSize() {
+    return (int)responseSize;
+}
+
+WiFiClient* HttpConnection::getStream() {
+    return &wifiClient;
+}
+
+void HttpConnection::end() {}
+
+void HttpConnection::close() {
+    wifiClient.stop();
+}
+
+namespace ConfigManager {
+
+bool loadRemoteConfig(RemoteConfig&, HttpConnection&) {
+    return true;
+}
+
+// Same query layout as the firmware, the fake server only reads offset/limit
+int buildImageUrl(const RemoteConfig& config, char* url, size_t size) {
+    return snprintf(url, size, "%s%s?format=%s&threshold=%d&template=%s",
+                    config.imageBaseUrl.c_str(), config.imagePath.c_str(),
+                    config.imageFormat.c_str(), config.imageThreshold, config.imageTemplate.c_str());
+}
+
+// No offset/limit: the fake server answers with its whole body
+int buildRegionUrl(const RemoteConfig& config, const LayoutRegion& region, char* url, size_t size) {
+    return snprintf(url, size, "%s%s?format=epd1&template=%s&width=%d&height=%d",
+                    config.imageBaseUrl.c_str(), config.imagePath.c_str(), region.templateName.c_str(),
+                    region.width, region.height);
+}
+
+}  // namespace ConfigManager
+
+namespace Telemetry {
+
+void beginCycle() {}
+void start(Phase) {}
+void stop(Phase) {}
+void addRequest() {}
+void addBytes(size_t) {}
+
+bool report(const RemoteConfig&, HttpConnection&) {
+    return true;
+}
+
+}  // namespace Telemetry
+
+namespace FrameStore {
+
+static bool recording = false;
+static uint16_t recordWidth = 0;
+static uint16_t recordHeight = 0;
+static std::vector<uint8_t> recorded;
+static size_t readPos = 0;
+
+bool begin() {
+    return true;
+}
+
+bool beginWrite(uint16_t width, uint16_t height) {
+    recording = true;
+    recordWidth = width;
+    recordHeight = height;
+    recorded.clear();
+    return true;
+}
+
+void write(const uint8_t* rows, size_t bytes) {
+    if (recording) {
+        recorded.insert(recorded.end(), rows, rows + bytes);
+    }
+}
+
+bool commit(const char* etag) {
+    if (!recording) {
+        return false;
+    }
+    recording = false;
+    fakeFlash.stored = true;
+    fakeFlash.width = recordWidth;
+    fakeFlash.height = recordHeight;
+    fakeFlash.frame = recorded;
+    fakeFlash.etag = etag;
+    fakeFlash.commits++;
+    return true;
+}
+
+void discard() {
+    recording = false;
+}
+
+bool open(uint16_t width, uint16_t height, char* etag, size_t etagSize) {
+    if (!fakeFlash.stored || fakeFlash.width != width || fakeFlash.height != height) {
+        return false;
+    }
+    snprintf(etag, etagSize, "%s", fakeFlash.etag.c_str());
+    readPos = 0;
+    return true;
+}
+
+size_t read(uint8_t* rows, size_t bytes) {
+    size_t count = min(bytes, fakeFlash.frame.size() - readPos);
+    memcpy(rows, fakeFlash.frame.data() + readPos, count);
+    readPos += count;
+    return count;
+}
+
+void close() {}
+
+}  // namespace FrameStore
@@ -0,0 +1,58 @@
+#ifndef FAKE_SERVER_H
+#define FAKE_SERVER_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+// What the fake HttpConnection answers: one resource, sliced by &offset=&limit=
+// like the renderer, 304 when If-None-Match equals etag
+// A dropped connection still announces the full size, as a real one would
+struct FakeServer {
+    std::vector<uint8_t> body;
+    std::string etag;
+    int status = 200;
+    bool reachable = true;
+    size_t dropAfter = 0;  // Cut the next response after this many bytes, then serve normally
+
+
+    int requests = 0;
+    int notModified = 0;
+    std::string lastUrl;
+
+    void reset() {
+        body.clear();
+        etag.clear();
+        status = 200;
+        reachable = true;
+        dropAfter = 0;
+        requests = 0;
+        notModified = 0;
+        lastUrl.clear();
+    }
+};
+
+extern FakeServer fakeServer;
+
+// What the fake FrameStore keeps in "flash": the last committed frame
+struct FakeFlash {
+    bool stored = false;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    std::vector<uint8_t> frame;
+    std::string etag;
+    int commits = 0;
+
+    void reset() {
+        stored = false;
+        width = 0;
+        height = 0;
+        frame.clear();
+        etag.clear();
+        commits = 0;
+    }
+};
+
+extern FakeFlash fakeFlash;
+
+#endif
@@ -0,0 +1,668 @@
+// Render path tests and benchmarks for [env:native]
+// Runs the real ui_renderer / display_driver / packbits / band_pipeline code
+// against a fake panel and a fake server: pio test -e native
+//
+// EINK_BENCH_STREAM=<file> replays a recorded response body in the benchmarks
+// (EINK_BENCH_FORMAT=epd1|rle|bmp, default epd1)
+
+#include <unity.h>
+#include <atomic>
+#include <climits>
+#include <new>
+#include "fake_server.h"
+#include "app_state.h"
+#include "display_driver.h"
+#include "error_icons.h"
+#include "frame_diff.h"
+#include <freertos/FreeRTOS.h>
+#include "ui_renderer.h"
+
+constexpr int WIDTH = FakePanel::WIDTH;
+constexpr int HEIGHT = FakePanel::HEIGHT;
+constexpr int FRAME_BYTES = FakePanel::FRAME_BYTES;
+constexpr int BENCH_FRAMES = 50;
+constexpr int BENCH_ICONS = 2000;
+
+// Regression bounds, measured on the current code with some headroom
+// A steady-state frame allocates nothing: URLs, ETags and pipeline queues are fixed
+constexpr double MAX_ALLOCS_PER_FRAME = 0;
+constexpr double MAX_DRAW_CALLS_PER_ICON = 40;
+
+// Count heap allocations made through operator new (String, std containers);
+// FreeRTOS objects are counted by the fake kernel
+static std::atomic<uint64_t> allocations{0};
+
+static uint64_t heapAllocations() {
+    return allocations + fakeRtosAllocations;
+}
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static RtcState rtc;
+static AppState state(rtc);
+static std::vector<uint8_t> frame;
+
+// Deterministic dashboard-like frame: header bar, card outlines, "text" blocks
+static std::vector<uint8_t> makeFrame(uint32_t seed) {
+    std::vector<uint8_t> out(FRAME_BYTES, 0xFF);
+    int bytesPerRow = WIDTH / 8;
+
+    for (int y = 0; y < 56; y++) {
+        memset(&out[y * bytesPerRow], 0x00, bytesPerRow);
+    }
+    for (int y = 80; y < HEIGHT - 20; y += 130) {
+        memset(&out[y * bytesPerRow + 2], 0x00, bytesPerRow - 4);
+    }
+
+    uint32_t rng = seed;
+    for (int line = 0; line < 24; line++) {
+        int y = 96 + line * 15;
+        int x = 4 + (line % 3) * 32;
+        for (int row = y; row < y + 9 && row < HEIGHT; row++) {
+            for (int col = x; col < x + 24; col++) {
+                rng = rng * 1664525u + 1013904223u;
+                out[row * bytesPerRow + col] = (uint8_t)(rng >> 24) | 0x81;
+            }
+        }
+    }
+    return out;
+}
+
+// PackBits, same framing as the renderer's encodePackBits
+static std::vector<uint8_t> packBits(const std::vector<uint8_t>& in) {
+    std::vector<uint8_t> out;
+    size_t i = 0;
+    while (i < in.size()) {
+        size_t run = 1;
+        while (i + run < in.size() && run < 128 && in[i + run] == in[i]) {
+            run++;
+        }
+        if (run >= 2) {
+            out.push_back((uint8_t)(257 - run));
+            out.push_back(in[i]);
+            i += run;
+            continue;
+        }
+        size_t end = i + 1;
+        while (end < in.size() && end - i < 128 && !(end + 1 < in.size() && in[end] == in[end + 1])) {
+            end++;
+        }
+        out.push_back((uint8_t)(end - i - 1));
+        out.insert(out.end(), in.begin() + i, in.begin() + end);
+        i = end;
+    }
+    return out;
+}
+
+static std::vector<uint8_t> withBmpHeader(const std::vector<uint8_t>& rows) {
+    std::vector<uint8_t> out(BMP_HEADER_SIZE, 0);
+    out[0] = 'B';
+    out[1] = 'M';
+    out.insert(out.end(), rows.begin(), rows.end());
+    return out;
+}
+
+static bool readFile(const char* path, std::vector<uint8_t>& out) {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    uint8_t buffer[4096];
+    size_t n;
+    out.clear();
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        out.insert(out.end(), buffer, buffer + n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Re-size the band buffers as UiRenderer::begin() would on a heap of this shape
+static void allocateBuffers(uint32_t maxAllocHeap) {
+    for (int i = 0; i < BAND_BUFFERS; i++) {
+        free(state.bandBuffers[i]);
+        state.bandBuffers[i] = nullptr;
+    }
+    state.bandBufferCount = 0;
+    state.bandBufferBytes = 0;
+
+    ESP.maxAllocHeap = maxAllocHeap;
+    TEST_ASSERT_TRUE(UiRenderer::begin(state));
+}
+
+// Each call is a config change to the renderer, which rebuilds its URLs
+static void configure(const char* format, bool stream) {
+    static uint32_t revision = 0;
+    state.config.revision = ++revision;
+    state.config.imageFormat = format;
+    state.config.imageStream = stream;
+    state.config.imageTemplate = "dashboard";
+    state.config.displayWidth = WIDTH;
+    state.config.displayHeight = HEIGHT;
+}
+
+// Refreshes run on the display task; wait for them before looking at the panel
+static FakePanel& panel() {
+    DisplayDriver::waitUntilIdle();
+    return fakePanel;
+}
+
+static bool panelShows(const std::vector<uint8_t>& expected) {
+    return memcmp(panel().ram, expected.data(), FRAME_BYTES) == 0;
+}
+
+void setUp() {
+    fakeServer.reset();
+    fakeServer.etag = "\"frame-1\"";
+    fakeFlash.reset();
+    panel().reset();
+    memset(&rtc, 0, sizeof(rtc));
+    allocateBuffers(110000);
+}
+
+void tearDown() {}
+
+static void test_streamed_epd1_reaches_controller_ram() {
+    configure("epd1", true);
+    fakeServer.body = frame;
+
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_TRUE(panelShows(frame));
+    TEST_ASSERT_EQUAL(1, fakeServer.requests);
+    TEST_ASSERT_EQUAL(1, panel().fullRefreshes);
+    TEST_ASSERT_EQUAL_STRING("\"frame-1\"", rtc.imageEtag);
+}
+
+static void test_streamed_rle_two_band_pipeline() {
+    allocateBuffers(FRAME_BYTES / 3);
+    TEST_ASSERT_EQUAL(BAND_BUFFERS, state.bandBufferCount);
+
+    configure("rle", true);
+    fakeServer.body = packBits(frame);
+
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_TRUE(panelShows(frame));
+    TEST_ASSERT_EQUAL(1, fakeServer.requests);
+}
+
+static void test_chunked_bmp_skips_header() {
+    allocateBuffers(FRAME_BYTES / 3);
+    configure("bmp", false);
+    fakeServer.body = withBmpHeader(frame);
+
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_TRUE(panelShows(frame));
+    TEST_ASSERT_GREATER_THAN(1, fakeServer.requests);
+}
+
+static void test_not_modified_skips_refresh() {
+    configure("epd1", true);
+    fakeServer.body = frame;
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL(1, fakeServer.notModified);
+    TEST_ASSERT_EQUAL(1, panel().fullRefreshes);
+}
+
+static void test_bench_refresh_modes() {
+    configure("epd1", true);
+    fakeServer.body = frame;
+
+    // Frame written to controller RAM, no waveform
+    UiRenderer::setRefreshMode(UiRenderer::REFRESH_NONE);
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_TRUE(panelShows(frame));
+    TEST_ASSERT_EQUAL(0, panel().fullRefreshes);
+    TEST_ASSERT_EQUAL(0, panel().partialRefreshes);
+
+    // One partial window over the frame
+    UiRenderer::setRefreshMode(UiRenderer::REFRESH_WINDOW);
+    rtc.imageEtag[0] = '\0';
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL(0, panel().fullRefreshes);
+    TEST_ASSERT_EQUAL(1, panel().partialRefreshes);
+
+    UiRenderer::setRefreshMode(UiRenderer::REFRESH_AUTO);
+}
+
+static void test_truncated_stream_fails() {
+    configure("epd1", true);
+    fakeServer.body.assign(frame.begin(), frame.begin() + FRAME_BYTES / 2);
+
+    TEST_ASSERT_FALSE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL_STRING("", rtc.imageEtag);
+}
+
+static void test_streamed_epd1_resumes_after_drop() {
+    allocateBuffers(FRAME_BYTES / 3);
+    configure("epd1", true);
+    fakeServer.body = frame;
+    fakeServer.dropAfter = FRAME_BYTES / 3 + 123;
+
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_TRUE(panelShows(frame));
+    TEST_ASSERT_EQUAL(2, fakeServer.requests);
+    TEST_ASSERT_EQUAL_STRING("\"frame-1\"", rtc.imageEtag);
+}
+
+static void test_streamed_rle_resumes_after_drop() {
+    allocateBuffers(FRAME_BYTES / 3);
+    configure("rle", true);
+    fakeServer.body = packBits(frame);
+    // Lands inside runs and literals alike over a few offsets
+    for (size_t drop = fakeServer.body.size() / 2; drop < fakeServer.body.size() / 2 + 4; drop++) {
+        panel().reset();
+        fakeServer.requests = 0;
+        fakeServer.dropAfter = drop;
+        rtc.imageEtag[0] = '\0';
+
+        TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+        TEST_ASSERT_TRUE(panelShows(frame));
+        TEST_ASSERT_EQUAL(2, fakeServer.requests);
+    }
+}
+
+static void test_chunked_resumes_short_chunk() {
+    allocateBuffers(FRAME_BYTES / 3);
+    configure("bmp", false);
+    fakeServer.body = withBmpHeader(frame);
+    fakeServer.etag = "";
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    int chunks = fakeServer.requests;
+
+    panel().reset();
+    fakeServer.requests = 0;
+    fakeServer.dropAfter = 1000;
+
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_TRUE(panelShows(frame));
+    TEST_ASSERT_EQUAL(chunks + 1, fakeServer.requests);
+}
+
+static void test_unreachable_server_gives_up() {
+    configure("epd1", true);
+    fakeServer.body = frame;
+    fakeServer.reachable = false;
+    unsigned long before = millis();
+
+    TEST_ASSERT_FALSE(UiRenderer::showRemoteImage(state));
+    // Backed off between attempts on the virtual clock
+    TEST_ASSERT_GREATER_OR_EQUAL(IMAGE_RETRY_BASE_MS * ((1 << IMAGE_RETRIES) - 1), millis() - before);
+}
+
+static void test_refresh_runs_behind_caller() {
+    configure("epd1", true);
+    fakeServer.body = frame;
+
+    // The caller gets control back while the panel is still busy with the waveform
+    fakePanel.holdRefresh = true;
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_TRUE(DisplayDriver::busy());
+    TEST_ASSERT_EQUAL(0, fakePanel.fullRefreshes);
+
+    fakePanel.holdRefresh = false;
+    TEST_ASSERT_EQUAL(1, panel().fullRefreshes);
+    TEST_ASSERT_FALSE(DisplayDriver::busy());
+    TEST_ASSERT_TRUE(panelShows(frame));
+}
+
+// Power cycle: controller RAM and RTC memory are gone, flash is not
+static void powerCycle() {
+    panel().reset();
+    memset(&rtc, 0, sizeof(rtc));
+}
+
+static void test_cached_frame_shown_at_boot() {
+    configure("epd1", true);
+    fakeServer.body = frame;
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL(1, fakeFlash.commits);
+
+    powerCycle();
+    TEST_ASSERT_TRUE(UiRenderer::showCachedFrame(state));
+    TEST_ASSERT_TRUE(panelShows(frame));
+    TEST_ASSERT_EQUAL_STRING("\"frame-1\"", rtc.imageEtag);
+
+    // The server still has that frame: revalidated, not fetched or refreshed again
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL(1, fakeServer.notModified);
+    TEST_ASSERT_EQUAL(1, panel().fullRefreshes);
+}
+
+static void test_cached_frame_replaces_error_screen() {
+    configure("epd1", true);
+    fakeServer.body = frame;
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+
+    // A frame that fails halfway is not cached, the panel falls back to the last good one
+    powerCycle();
+    std::vector<uint8_t> next = makeFrame(7);
+    fakeServer.body.assign(next.begin(), next.begin() + FRAME_BYTES / 2);
+    fakeServer.etag = "\"frame-2\"";
+
+    TEST_ASSERT_FALSE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_TRUE(panelShows(frame));
+    TEST_ASSERT_EQUAL(1, fakeFlash.commits);
+    TEST_ASSERT_TRUE(rtc.lastRenderSuccess);
+    TEST_ASSERT_EQUAL_STRING("", rtc.imageEtag);
+}
+
+static void test_wrong_size_rejected() {
+    configure("epd1", true);
+    state.config.displayWidth = 640;
+    fakeServer.body = frame;
+
+    TEST_ASSERT_FALSE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL(0, fakeServer.requests);
+}
+
+static void test_scaled_bitmap_matches_per_pixel() {
+    for (uint8_t scale = 1; scale <= 5; scale++) {
+        panel().reset();
+        DisplayDriver::drawScaledBitmap(3, 5, ICON_HTTP_ERROR, ICON_WIDTH, ICON_HEIGHT, GxEPD_BLACK, scale);
+
+        for (int y = 0; y < ICON_HEIGHT * scale; y++) {
+            for (int x = 0; x < ICON_WIDTH * scale; x++) {
+                int sx = x / scale;
+                int sy = y / scale;
+                bool set = pgm_read_byte(&ICON_HTTP_ERROR[sy * (ICON_WIDTH / 8) + sx / 8]) & (0x80 >> (sx & 7));
+                if (set != fakePanel.canvasPixel(3 + x, 5 + y)) {
+                    char message[64];
+                    snprintf(message, sizeof(message), "scale %d: pixel (%d,%d) differs", scale, x, y);
+                    TEST_FAIL_MESSAGE(message);
+                }
+            }
+        }
+    }
+}
+
+static void test_frame_diff_partial_refresh() {
+    // Leaves frame diffing on for the rest of the run, keep the frame diff tests last
+    TEST_ASSERT_TRUE(FrameDiff::begin());
+    configure("epd1", true);
+    fakeServer.body = frame;
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL(1, panel().fullRefreshes);
+
+    std::vector<uint8_t> changed = frame;
+    for (int y = 200; y < 216; y++) {
+        changed[y * (WIDTH / 8) + 40] ^= 0xFF;
+    }
+    fakeServer.body = changed;
+    fakeServer.etag = "\"frame-2\"";
+
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL(1, panel().fullRefreshes);
+    TEST_ASSERT_EQUAL(1, panel().partialRefreshes);
+    TEST_ASSERT_TRUE(panelShows(changed));
+    TEST_ASSERT_EQUAL(0, memcmp(panel().previousRam, changed.data(), FRAME_BYTES));
+
+    // Same pixels under a new ETag: only the frame itself goes over SPI, no refresh
+    fakeServer.etag = "\"frame-3\"";
+    uint32_t bytesBefore = panel().ramBytesWritten;
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    DisplayDriver::waitUntilIdle();
+    TEST_ASSERT_EQUAL(1, panel().partialRefreshes);
+    TEST_ASSERT_EQUAL(FRAME_BYTES, panel().ramBytesWritten - bytesBefore);
+    TEST_ASSERT_TRUE(panelShows(changed));
+}
+
+// Flip a small block so the next frame is a cheap partial update
+static std::vector<uint8_t> withChange(const std::vector<uint8_t>& base, int y) {
+    std::vector<uint8_t> out = base;
+    for (int row = y; row < y + 16; row++) {
+        out[row * (WIDTH / 8) + 20] ^= 0xFF;
+    }
+    return out;
+}
+
+static void test_partial_budget_forces_full_refresh() {
+    // Runs after test_frame_diff_partial_refresh, frame diffing is on
+    configure("epd1", true);
+    state.config.partialRefreshCycles = 2;
+    state.config.fullRefreshMinutes = 1;
+    FrameDiff::invalidate();
+    fakeServer.body = frame;
+    fakeServer.etag = "";
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL(1, panel().fullRefreshes);
+
+    // Cycle budget: two fast refreshes, then a full one
+    for (int i = 0; i < 3; i++) {
+        fakeServer.body = withChange(frame, 100 + i * 40);
+        TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    }
+    TEST_ASSERT_EQUAL(2, panel().partialRefreshes);
+    TEST_ASSERT_EQUAL(2, panel().fullRefreshes);
+    TEST_ASSERT_TRUE(panelShows(fakeServer.body));
+
+    // Time budget: the first change after a minute gets the full waveform
+    delay(61000);
+    fakeServer.body = withChange(frame, 300);
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL(3, panel().fullRefreshes);
+
+    state.config = RemoteConfig();
+}
+
+static void test_due_region_refreshes_its_window() {
+    // Runs after the frame diff tests, frame diffing is on
+    configure("epd1", true);
+    fakeServer.body = frame;
+    fakeServer.etag = "\"frame-3\"";
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+
+    LayoutRegion& clock = state.config.regions[0];
+    clock.x = 16;
+    clock.y = 40;
+    clock.width = 64;
+    clock.height = 32;
+    clock.intervalSec = 60;
+    clock.templateName = "clock.html";
+    state.config.regionCount = 1;
+
+    std::vector<uint8_t> pixels(clock.width / 8 * clock.height);
+    std::vector<uint8_t> expected = frame;
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = (uint8_t)(i * 37);
+        expected[(clock.y + i / 8) * (WIDTH / 8) + clock.x / 8 + i % 8] = pixels[i];
+    }
+    fakeServer.body = pixels;
+    fakeServer.etag = "\"clock-1\"";
+    fakeServer.requests = 0;
+    uint32_t fullBefore = panel().fullRefreshes;
+    uint32_t partialBefore = panel().partialRefreshes;
+
+    TEST_ASSERT_EQUAL(1, UiRenderer::showDueRegions(state));
+    TEST_ASSERT_TRUE(panelShows(expected));
+    TEST_ASSERT_EQUAL(0, memcmp(panel().previousRam, expected.data(), FRAME_BYTES));
+    TEST_ASSERT_EQUAL(partialBefore + 1, panel().partialRefreshes);
+    TEST_ASSERT_EQUAL(fullBefore, panel().fullRefreshes);
+    TEST_ASSERT_TRUE(fakeServer.lastUrl.find("width=64&height=32") != std::string::npos);
+
+    // Not due again until its interval is up, then revalidated with its own ETag
+    TEST_ASSERT_EQUAL(0, UiRenderer::showDueRegions(state));
+    TEST_ASSERT_EQUAL(1, fakeServer.requests);
+    TEST_ASSERT_TRUE(UiRenderer::msUntilNextRegion(state) <= 60000);
+    delay(60000);
+    TEST_ASSERT_EQUAL(0, UiRenderer::showDueRegions(state));
+    TEST_ASSERT_EQUAL(2, fakeServer.requests);
+    TEST_ASSERT_EQUAL(1, fakeServer.notModified);
+
+    state.config = RemoteConfig();
+}
+
+static void test_failed_region_resumes_after_full_image() {
+    // Small bands so the region arrives in two of them
+    allocateBuffers(FRAME_BYTES / 16);
+    configure("epd1", true);
+    fakeServer.body = frame;
+    fakeServer.etag = "\"frame-4\"";
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+
+    LayoutRegion& strip = state.config.regions[0];
+    strip.x = 0;
+    strip.y = 0;
+    strip.width = 64;
+    strip.height = HEIGHT;
+    strip.intervalSec = 60;
+    strip.templateName = "strip.html";
+    state.config.regionCount = 1;
+    std::vector<uint8_t> pixels(strip.width / 8 * strip.height, 0x5A);
+    TEST_ASSERT_TRUE(pixels.size() > state.bandBufferBytes);
+
+    // A region that fails before any row arrives leaves the windows usable
+    fakeServer.body = pixels;
+    fakeServer.status = 404;
+    TEST_ASSERT_EQUAL(0, UiRenderer::showDueRegions(state));
+    TEST_ASSERT_TRUE(UiRenderer::windowsReady());
+    fakeServer.status = 200;
+
+    // Cut after the first band: the frame copy is partial, regions wait for a full image
+    delay(60000);
+    fakeServer.etag = "\"strip-1\"";
+    fakeServer.dropAfter = state.bandBufferBytes + 100;
+    TEST_ASSERT_EQUAL(0, UiRenderer::showDueRegions(state));
+    TEST_ASSERT_FALSE(UiRenderer::windowsReady());
+    TEST_ASSERT_EQUAL(ULONG_MAX, UiRenderer::msUntilNextRegion(state));
+
+    // The unchanged full image is downloaded again rather than answered with a 304
+    fakeServer.body = frame;
+    fakeServer.etag = "\"frame-4\"";
+    fakeServer.notModified = 0;
+    TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    TEST_ASSERT_EQUAL(0, fakeServer.notModified);
+    TEST_ASSERT_TRUE(UiRenderer::windowsReady());
+
+    delay(60000);
+    fakeServer.body = pixels;
+    fakeServer.etag = "\"strip-1\"";
+    TEST_ASSERT_EQUAL(1, UiRenderer::showDueRegions(state));
+    TEST_ASSERT_EQUAL(0, memcmp(panel().ram, pixels.data(), 8));
+
+    state.config = RemoteConfig();
+    allocateBuffers(FRAME_BYTES / 3);
+}
+
+// Render BENCH_FRAMES frames of body and report ns per frame byte and allocations per frame
+static void benchFrames(const char* label, const char* format, bool stream, const std::vector<uint8_t>& body) {
+    configure(format, stream);
+    fakeServer.body = body;
+    fakeServer.etag = "";
+    UiRenderer::showRemoteImage(state);  // Warm up
+
+    uint64_t allocationsBefore = heapAllocations();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        TEST_ASSERT_TRUE(UiRenderer::showRemoteImage(state));
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    double allocsPerFrame = (double)(heapAllocations() - allocationsBefore) / BENCH_FRAMES;
+
+    char message[160];
+    snprintf(message, sizeof(message), "%s: %.2f ns/byte, %.0f us/frame, %.1f allocs/frame, %d bands, %u body bytes",
+             label, (double)ns / ((double)BENCH_FRAMES * FRAME_BYTES), ns / 1000.0 / BENCH_FRAMES,
+             allocsPerFrame, state.bandBufferBytes > 0 ? (int)((FRAME_BYTES + state.bandBufferBytes - 1) / state.bandBufferBytes) : 0,
+             (unsigned)body.size());
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(allocsPerFrame <= MAX_ALLOCS_PER_FRAME);
+}
+
+static void bench_stream_epd1() {
+    allocateBuffers(FRAME_BYTES / 3);
+    benchFrames("epd1 stream", "epd1", true, frame);
+}
+
+static void bench_stream_rle() {
+    allocateBuffers(FRAME_BYTES / 3);
+    benchFrames("rle stream", "rle", true, packBits(frame));
+}
+
+static void bench_chunked_bmp() {
+    allocateBuffers(FRAME_BYTES / 3);
+    benchFrames("bmp chunks", "bmp", false, withBmpHeader(frame));
+}
+
+static void bench_recorded_stream() {
+    const char* path = getenv("EINK_BENCH_STREAM");
+    if (path == nullptr) {
+        TEST_IGNORE_MESSAGE("EINK_BENCH_STREAM not set");
+    }
+
+    std::vector<uint8_t> body;
+    if (!readFile(path, body)) {
+        TEST_FAIL_MESSAGE("cannot read EINK_BENCH_STREAM");
+    }
+    const char* format = getenv("EINK_BENCH_FORMAT");
+    format = format != nullptr ? format : "epd1";
+    allocateBuffers(FRAME_BYTES / 3);
+    benchFrames(path, format, strcmp(format, "bmp") != 0, body);
+}
+
+static void bench_scaled_bitmap() {
+    char message[160];
+    for (uint8_t scale = 1; scale <= 2; scale++) {
+        panel().reset();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BENCH_ICONS; i++) {
+            DisplayDriver::drawScaledBitmap(200, 100, ICON_HTTP_ERROR, ICON_WIDTH, ICON_HEIGHT, GxEPD_BLACK, scale);
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        double callsPerIcon = (double)fakePanel.drawCalls / BENCH_ICONS;
+
+        // Draw calls are what costs on the device; the fake's fillRect time is included here
+        snprintf(message, sizeof(message), "drawScaledBitmap x%d: %.0f ns/icon, %.1f draw calls/icon, %.1f Mpx/s",
+                 scale, (double)ns / BENCH_ICONS, callsPerIcon,
+                 (double)fakePanel.pixelsDrawn * 1000.0 / (double)ns);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_TRUE(callsPerIcon <= MAX_DRAW_CALLS_PER_ICON);
+    }
+}
+
+int main() {
+    frame = makeFrame(1);
+    DisplayDriver::init(true);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_streamed_epd1_reaches_controller_ram);
+    RUN_TEST(test_streamed_rle_two_band_pipeline);
+    RUN_TEST(test_chunked_bmp_skips_header);
+    RUN_TEST(test_not_modified_skips_refresh);
+    RUN_TEST(test_bench_refresh_modes);
+    RUN_TEST(test_truncated_stream_fails);
+    RUN_TEST(test_streamed_epd1_resumes_after_drop);
+    RUN_TEST(test_streamed_rle_resumes_after_drop);
+    RUN_TEST(test_chunked_resumes_short_chunk);
+    RUN_TEST(test_unreachable_server_gives_up);
+    RUN_TEST(test_wrong_size_rejected);
+    RUN_TEST(test_refresh_runs_behind_caller);
+    RUN_TEST(test_cached_frame_shown_at_boot);
+    RUN_TEST(test_cached_frame_replaces_error_screen);
+    RUN_TEST(test_scaled_bitmap_matches_per_pixel);
+    RUN_TEST(bench_stream_epd1);
+    RUN_TEST(bench_stream_rle);
+    RUN_TEST(bench_chunked_bmp);
+    RUN_TEST(bench_recorded_stream);
+    RUN_TEST(bench_scaled_bitmap);
+    RUN_TEST(test_frame_diff_partial_refresh);
+    RUN_TEST(test_partial_budget_forces_full_refresh);
+    RUN_TEST(test_due_region_refreshes_its_window);
+    RUN_TEST(test_failed_region_resumes_after_full_image);
+    return UNITY_END();
+}